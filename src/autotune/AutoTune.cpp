@@ -0,0 +1,189 @@
+
+#if defined(_MSC_VER)
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+#include "CPUWarmUp.h"
+#include "StopWatch.h"
+
+#include "jstd/ArrayRotate_SIMD.h"
+#include "jstd/ArrayRotate_Params.h"
+#include "jstd/ArrayRotate_Calibrate.h"
+
+//
+// Offline kernel autotuner.
+//
+// Benchmarks every forward move kernel of the AVX stash rotation for each
+// stash size class and move size class on this machine, and writes the winners
+// (and the calibrated prefetch parameters) to a profile file.
+//
+// Usage:
+//
+//   autotune [profile.json]
+//
+//   export JSTD_ROTATE_PROFILE=/path/to/profile.json
+//
+// Then simd::rotate() loads the profile at the first use.
+//
+
+using namespace jstd::simd;
+
+// The representative stash registers of each stash class (1 - 6, 7 - 8, 9 - 12).
+static const std::size_t kStashRegs[kStashClassCount] = { 4, 8, 12 };
+
+// The representative move bytes of each size class, about the middle of the class.
+static const std::size_t kMoveBytes[kSizeClassCount] = {
+    16 * 1024, 256 * 1024, 4 * 1024 * 1024, 64 * 1024 * 1024
+};
+
+// Each measure moves about this many bytes.
+static const std::size_t kBytesPerMeasure = 64 * 1024 * 1024;
+static const int kMeasureRepeats = 3;
+
+// Keep the built-in kernel unless another one is 2% faster at least.
+static const double kMinGain = 0.02;
+
+typedef std::uint32_t item_type;
+
+static void force_kernel(int kernel)
+{
+    RotateProfile profile;
+    profile.loaded = true;
+    for (std::size_t stash_class = 0; stash_class < kStashClassCount; stash_class++) {
+        for (std::size_t size_class = 0; size_class < kSizeClassCount; size_class++) {
+            profile.kernels[stash_class][size_class] = (std::uint8_t)kernel;
+        }
+    }
+    set_rotate_profile(profile);
+}
+
+static bool verify_kernel(int kernel)
+{
+    static const std::size_t kLength = 100000;
+
+    std::vector<item_type> array(kLength), expected(kLength);
+    for (std::size_t n = 0; n < kStashClassCount; n++) {
+        std::size_t offset = (kStashRegs[n] * kAVXRegBytes - 8) / sizeof(item_type);
+        for (std::size_t i = 0; i < kLength; i++) {
+            array[i] = expected[i] = (item_type)i;
+        }
+        std::rotate(expected.begin(), expected.begin() + offset, expected.end());
+
+        force_kernel(kernel);
+        jstd::simd::rotate(&array[0], kLength, offset);
+        reset_rotate_profile();
+
+        if (array != expected)
+            return false;
+    }
+    return true;
+}
+
+static double measure_kernel(int kernel, std::vector<item_type> & array,
+                             std::size_t stash_class, std::size_t size_class)
+{
+    // The stash bytes is a bit less than the stash registers, same as the dispatcher.
+    std::size_t offset = (kStashRegs[stash_class] * kAVXRegBytes - 8) / sizeof(item_type);
+    std::size_t length = kMoveBytes[size_class] / sizeof(item_type) + offset;
+    std::size_t iterations = std::max(kBytesPerMeasure / kMoveBytes[size_class], std::size_t(1));
+
+    if (kernel == kMoveKernelDefault)
+        reset_rotate_profile();
+    else
+        force_kernel(kernel);
+
+    test::StopWatch sw;
+    double best_time = 0.0;
+    for (int repeat = 0; repeat < kMeasureRepeats; repeat++) {
+        sw.start();
+        for (std::size_t i = 0; i < iterations; i++) {
+            jstd::simd::rotate(&array[0], length, offset);
+        }
+        sw.stop();
+        double elapsed = sw.getElapsedMillisec();
+        if (repeat == 0 || elapsed < best_time)
+            best_time = elapsed;
+    }
+
+    reset_rotate_profile();
+    return best_time;
+}
+
+int main(int argc, char * argv[])
+{
+    const char * filename = (argc > 1) ? argv[1] : "rotate_profile.json";
+
+    test::CPU::WarmUp warmUp(1000);
+
+    printf(" Prefetch calibration ...\n\n");
+    RotateCalibrateResult calibrate = calibrate_rotate_params();
+    printf(" prefetch_offset = %u, prefetch_hint = %s\n\n",
+           (uint32_t)calibrate.params.prefetch_offset,
+           prefetch_hint_name(calibrate.params.prefetch_hint));
+
+    bool kernel_ok[kMoveKernelLast];
+    for (int kernel = 0; kernel < kMoveKernelLast; kernel++) {
+        kernel_ok[kernel] = verify_kernel(kernel);
+        if (!kernel_ok[kernel])
+            printf(" Kernel %s: Failed, skipped.\n", move_kernel_name(kernel));
+    }
+
+    std::size_t max_length = kMoveBytes[kSizeClassCount - 1] / sizeof(item_type) + 1024;
+    std::vector<item_type> array(max_length);
+    for (std::size_t i = 0; i < max_length; i++) {
+        array[i] = (item_type)i;
+    }
+
+    RotateProfile profile;
+    profile.loaded = true;
+
+    for (std::size_t stash_class = 0; stash_class < kStashClassCount; stash_class++) {
+        for (std::size_t size_class = 0; size_class < kSizeClassCount; size_class++) {
+            printf(" stash_%u.size_%u (stash regs = %u, move bytes = %u, unit: ms)\n\n",
+                   (uint32_t)stash_class, (uint32_t)size_class,
+                   (uint32_t)kStashRegs[stash_class], (uint32_t)kMoveBytes[size_class]);
+
+            double default_time = measure_kernel(kMoveKernelDefault, array, stash_class, size_class);
+            int best_kernel = kMoveKernelDefault;
+            double best_time = default_time;
+            printf(" %-22s %10.3f\n", move_kernel_name(kMoveKernelDefault), default_time);
+
+            for (int kernel = kMoveKernelDefault + 1; kernel < kMoveKernelLast; kernel++) {
+                if (!kernel_ok[kernel])
+                    continue;
+                double elapsed = measure_kernel(kernel, array, stash_class, size_class);
+                printf(" %-22s %10.3f\n", move_kernel_name(kernel), elapsed);
+                if (elapsed < best_time) {
+                    best_time = elapsed;
+                    best_kernel = kernel;
+                }
+            }
+
+            if (best_time > default_time * (1.0 - kMinGain))
+                best_kernel = kMoveKernelDefault;
+            profile.kernels[stash_class][size_class] = (std::uint8_t)best_kernel;
+
+            printf("\n winner: %s\n\n", move_kernel_name(best_kernel));
+        }
+    }
+
+    if (save_rotate_profile(filename, calibrate.params, profile)) {
+        printf(" Profile saved to: %s\n\n", filename);
+        return 0;
+    } else {
+        printf(" Error: can't write the profile: %s\n\n", filename);
+        return 1;
+    }
+}
@@ -0,0 +1,337 @@
+
+#ifndef JSTD_TEST_BENCH_ISOLATION_H
+#define JSTD_TEST_BENCH_ISOLATION_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#if defined(_WIN32) || defined(WIN32) || defined(OS_WINDOWS) || defined(_WINDOWS_)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+#include "StopWatch.h"
+
+#include "jstd/config.h"
+#include "jstd/stddef.h"
+
+#if JSTD_IS_X86
+#if defined(__CLFLUSHOPT__)
+#include <immintrin.h>
+#define ISOLATION_CLFLUSH(p)    _mm_clflushopt((void *)(p))
+#else
+#include <emmintrin.h>
+#define ISOLATION_CLFLUSH(p)    _mm_clflush((const void *)(p))
+#endif
+#endif // JSTD_IS_X86
+
+//
+// Benchmark isolation: CPU pinning, cache state control and frequency settling.
+//
+// Without it, the algorithms of a benchmark run back to back on the same array,
+// so each one inherits the cache state of the previous one, the thread can move
+// to another core between two runs, and the first runs are measured while the
+// core is still ramping up its frequency.
+//
+// Before each timed run, BenchIsolation::prepare() puts the array into the same
+// cache state for every algorithm:
+//
+//   CacheWarm   read the array once, the part that fits is in the cache.
+//   CacheCold   flush each cache line of the array (clflushopt / clflush sweep),
+//               or walk an eviction buffer of 2x the LLC on the other CPUs.
+//
+// The frequency is settled when the time of a fixed dependent ALU chain is stable
+// (max / min - 1 <= tolerance) over a few samples in a row.
+//
+
+namespace test {
+
+enum CacheMode {
+    CacheNone,
+    CacheWarm,
+    CacheCold
+};
+
+static const char * const kCacheModeNames[] = {
+    "none", "warm", "cold"
+};
+
+static const std::size_t kCacheLineSize = 64;
+
+static bool pin_to_cpu(int cpu)
+{
+    if (cpu < 0)
+        return false;
+#if defined(_WIN32) || defined(WIN32) || defined(OS_WINDOWS) || defined(_WINDOWS_)
+    if (cpu >= (int)(sizeof(DWORD_PTR) * 8))
+        return false;
+    DWORD_PTR mask = (DWORD_PTR)1 << cpu;
+    return (::SetThreadAffinityMask(::GetCurrentThread(), mask) != 0);
+#elif defined(__linux__)
+    if (cpu >= CPU_SETSIZE)
+        return false;
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(cpu, &cpu_set);
+    return (::sched_setaffinity(0, sizeof(cpu_set), &cpu_set) == 0);
+#else
+    return false;
+#endif
+}
+
+// The size of the last level cache, or a guess if it's unknown.
+static std::size_t get_llc_size()
+{
+    static const std::size_t kDefaultLLCSize = 32 * 1024 * 1024;
+#if defined(__linux__) && defined(_SC_LEVEL3_CACHE_SIZE)
+    long llc_size = ::sysconf(_SC_LEVEL3_CACHE_SIZE);
+    if (llc_size <= 0)
+        llc_size = ::sysconf(_SC_LEVEL2_CACHE_SIZE);
+    if (llc_size > 0)
+        return (std::size_t)llc_size;
+#endif
+    return kDefaultLLCSize;
+}
+
+//
+// Write back and invalidate the cache lines of [data, data + bytes).
+// Returns false if there is no cache flush instruction.
+//
+static bool flush_cache_range(const void * data, std::size_t bytes)
+{
+#if JSTD_IS_X86
+    const char * first = (const char *)((uintptr_t)data & ~(uintptr_t)(kCacheLineSize - 1));
+    const char * last = (const char *)data + bytes;
+    for (const char * p = first; p < last; p += kCacheLineSize) {
+        ISOLATION_CLFLUSH(p);
+    }
+    _mm_mfence();
+    return true;
+#else
+    (void)data;
+    (void)bytes;
+    return false;
+#endif
+}
+
+//
+// Touch each cache line of [data, data + bytes) once.
+//
+static void touch_cache_range(const void * data, std::size_t bytes)
+{
+    const volatile char * first = (const volatile char *)data;
+    char sum = 0;
+    for (std::size_t i = 0; i < bytes; i += kCacheLineSize) {
+        sum ^= first[i];
+    }
+    if (bytes > 0)
+        sum ^= first[bytes - 1];
+    volatile char result = sum;
+    (void)result;
+}
+
+class CacheEvictor {
+private:
+    char *      buffer_;
+    std::size_t size_;
+
+public:
+    CacheEvictor() : buffer_(nullptr), size_(0) {}
+
+    ~CacheEvictor() {
+        this->destroy();
+    }
+
+    bool is_valid() const { return (this->buffer_ != nullptr); }
+
+    bool create() {
+        this->destroy();
+        std::size_t size = get_llc_size() * 2;
+        this->buffer_ = (char *)::malloc(size);
+        if (this->buffer_ == nullptr)
+            return false;
+        this->size_ = size;
+        for (std::size_t i = 0; i < size; i++) {
+            this->buffer_[i] = (char)i;
+        }
+        return true;
+    }
+
+    void destroy() {
+        if (this->buffer_ != nullptr) {
+            ::free(this->buffer_);
+            this->buffer_ = nullptr;
+            this->size_ = 0;
+        }
+    }
+
+    // Write each cache line, so the dirty lines of the other data are written back too.
+    void evict() {
+        volatile char * buffer = this->buffer_;
+        for (std::size_t i = 0; i < this->size_; i += kCacheLineSize) {
+            buffer[i] = (char)(buffer[i] + 1);
+        }
+    }
+};
+
+struct FrequencyState {
+    bool    settled;
+    int     samples;
+    double  spread;         // max / min - 1 of the last samples
+    double  elapsed;        // unit: ms
+};
+
+//
+// The time of a dependent multiply-add chain, it only depends on the core frequency.
+//
+static JSTD_NO_INLINE
+double frequency_sample(std::size_t iterations)
+{
+    test::StopWatch sw;
+    volatile uint64_t seed = 1;
+    uint64_t x = seed;
+    sw.start();
+    for (std::size_t i = 0; i < iterations; i++) {
+        x = x * 6364136223846793005ull + 1442695040888963407ull;
+    }
+    sw.stop();
+    seed = x;
+    return sw.getElapsedMillisec();
+}
+
+//
+// Spin until the frequency is stable: the last stable_samples samples are within
+// the tolerance. Returns settled = false after timeout (unit: ms).
+//
+static FrequencyState wait_frequency_settled(double tolerance = 0.02, int stable_samples = 5,
+                                             double timeout = 2000.0)
+{
+    // About 1 ms per sample at 4 GHz.
+    static const std::size_t kSampleIterations = 1000000;
+    static const int kMaxStableSamples = 16;
+
+    if (stable_samples < 2)
+        stable_samples = 2;
+    if (stable_samples > kMaxStableSamples)
+        stable_samples = kMaxStableSamples;
+
+    double window[kMaxStableSamples];
+    FrequencyState state;
+    state.settled = false;
+    state.samples = 0;
+    state.spread = 0.0;
+    state.elapsed = 0.0;
+
+    while (state.elapsed < timeout) {
+        double sample = frequency_sample(kSampleIterations);
+        window[state.samples % stable_samples] = sample;
+        state.samples++;
+        state.elapsed += sample;
+
+        if (state.samples >= stable_samples) {
+            double min_time = window[0], max_time = window[0];
+            for (int i = 1; i < stable_samples; i++) {
+                if (window[i] < min_time) min_time = window[i];
+                if (window[i] > max_time) max_time = window[i];
+            }
+            state.spread = (min_time > 0.0) ? (max_time / min_time - 1.0) : 0.0;
+            if (state.spread <= tolerance) {
+                state.settled = true;
+                break;
+            }
+        }
+    }
+    return state;
+}
+
+class BenchIsolation {
+private:
+    int             cpu_;
+    bool            pinned_;
+    bool            settle_;
+    CacheMode       cache_mode_;
+    CacheEvictor    evictor_;
+
+public:
+    BenchIsolation() : cpu_(-1), pinned_(false), settle_(false), cache_mode_(CacheNone) {}
+
+    bool is_pinned() const { return this->pinned_; }
+    CacheMode cache_mode() const { return this->cache_mode_; }
+
+    //
+    // cpu < 0: don't pin, settle: check the frequency before each run.
+    // The settings are printed to log (stderr if the results go to stdout).
+    //
+    void setup(int cpu, CacheMode cache_mode, bool settle, FILE * log = stdout) {
+        this->cpu_ = cpu;
+        this->cache_mode_ = cache_mode;
+        this->settle_ = settle;
+
+        if (cpu >= 0) {
+            this->pinned_ = pin_to_cpu(cpu);
+            if (!this->pinned_)
+                fprintf(stderr, "Warning: can't pin the thread to cpu %d.\n\n", cpu);
+        }
+
+#if !JSTD_IS_X86
+        if (cache_mode == CacheCold) {
+            if (!this->evictor_.create())
+                fprintf(stderr, "Warning: can't allocate the eviction buffer.\n\n");
+        }
+#endif
+
+        fprintf(log, " Isolation: cpu: %s, cache: %s", (this->pinned_ ? "pinned" : "any"),
+                kCacheModeNames[cache_mode]);
+        if (this->pinned_)
+            fprintf(log, " (cpu %d)", cpu);
+        if (settle) {
+            FrequencyState state = wait_frequency_settled();
+            fprintf(log, ", frequency: %s (spread %0.1f %%, %d samples, %0.1f ms)",
+                    (state.settled ? "settled" : "not settled"),
+                    state.spread * 100.0, state.samples, state.elapsed);
+        }
+        fprintf(log, "\n\n");
+    }
+
+    //
+    // Call it before each timed run of [data, data + bytes).
+    //
+    void prepare(const void * data, std::size_t bytes) {
+        switch (this->cache_mode_) {
+            case CacheWarm:
+                touch_cache_range(data, bytes);
+                break;
+            case CacheCold:
+                if (!flush_cache_range(data, bytes) && this->evictor_.is_valid())
+                    this->evictor_.evict();
+                break;
+            default:
+                break;
+        }
+
+        if (this->settle_) {
+            // A short check, the frequency was settled by setup().
+            wait_frequency_settled(0.02, 3, 50.0);
+        }
+    }
+};
+
+} // namespace test
+
+#undef ISOLATION_CLFLUSH
+
+#endif // JSTD_TEST_BENCH_ISOLATION_H
@@ -0,0 +1,331 @@
+
+#ifndef JSTD_TEST_BENCH_OPTIONS_H
+#define JSTD_TEST_BENCH_OPTIONS_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "BenchIsolation.h"
+
+//
+// Command line options of the benchmark parameter sweep.
+//
+// Range syntax (RANGE):
+//
+//   100M               a single value, K = 10^3, M = 10^6, G = 10^9
+//   1,7,33,1000        a list
+//   1K:1M:*2           start:stop:*factor, geometric (inclusive)
+//   0:256:+32          start:stop:+step, arithmetic (inclusive), "+" is optional
+//   1,50%,33%          offsets only: a percentage of the length
+//
+// The items of a list can also be ranges: "1:8,100,1K:4K:*2".
+//
+
+namespace test {
+
+struct SweepValue {
+    std::size_t value;
+    // Only for the offsets: value is a percentage of the length.
+    bool        is_percent;
+
+    SweepValue(std::size_t _value = 0, bool _is_percent = false)
+        : value(_value), is_percent(_is_percent) {}
+
+    std::size_t resolve(std::size_t length) const {
+        if (this->is_percent)
+            return (std::size_t)((double)length * (double)this->value / 100.0);
+        else
+            return this->value;
+    }
+};
+
+enum OutputFormat {
+    OutputText,
+    OutputJson,
+    OutputCsv
+};
+
+struct BenchOptions {
+    bool                        sweep;
+    bool                        help;
+    bool                        latency;
+    bool                        divide;
+    bool                        perf;
+    bool                        roofline;
+    bool                        settle;
+    int                         cpu;
+    CacheMode                   cache;
+    std::vector<SweepValue>     lengths;
+    std::vector<SweepValue>     offsets;
+    std::vector<SweepValue>     elem_sizes;
+    std::vector<SweepValue>     alignments;
+    std::vector<std::string>    algorithms;
+    std::size_t                 repeats;
+    std::size_t                 warmups;
+    OutputFormat                format;
+    std::string                 output;
+
+    BenchOptions() : sweep(false), help(false), latency(false), divide(false), perf(false), roofline(false), settle(false),
+                     cpu(-1), cache(CacheWarm), repeats(5), warmups(1), format(OutputText) {}
+};
+
+static bool parse_number(const char * first, const char * last, std::size_t & value)
+{
+    if (first >= last)
+        return false;
+
+    char * end = nullptr;
+    unsigned long long number = ::strtoull(first, &end, 10);
+    if (end == first)
+        return false;
+
+    if (end < last) {
+        switch (*end) {
+            case 'K': case 'k':
+                number *= 1000ull;
+                end++;
+                break;
+            case 'M': case 'm':
+                number *= 1000000ull;
+                end++;
+                break;
+            case 'G': case 'g':
+                number *= 1000000000ull;
+                end++;
+                break;
+            default:
+                break;
+        }
+    }
+    value = (std::size_t)number;
+    return (end == last);
+}
+
+//
+// Parse one item of a list: "N", "N%", "start:stop:*factor" or "start:stop:+step".
+//
+static bool parse_range_item(const char * first, const char * last,
+                             std::vector<SweepValue> & values, bool allow_percent)
+{
+    const char * colon1 = (const char *)::memchr(first, ':', last - first);
+    if (colon1 == nullptr) {
+        bool is_percent = (last > first && *(last - 1) == '%');
+        if (is_percent && !allow_percent)
+            return false;
+        std::size_t value;
+        if (!parse_number(first, is_percent ? (last - 1) : last, value))
+            return false;
+        values.push_back(SweepValue(value, is_percent));
+        return true;
+    }
+
+    std::size_t start, stop, step = 1;
+    bool is_geometric = false;
+    const char * colon2 = (const char *)::memchr(colon1 + 1, ':', last - (colon1 + 1));
+    if (!parse_number(first, colon1, start))
+        return false;
+    if (colon2 != nullptr) {
+        if (!parse_number(colon1 + 1, colon2, stop))
+            return false;
+        const char * step_first = colon2 + 1;
+        if (step_first < last && (*step_first == '*' || *step_first == 'x')) {
+            is_geometric = true;
+            step_first++;
+        } else if (step_first < last && *step_first == '+') {
+            step_first++;
+        }
+        if (!parse_number(step_first, last, step))
+            return false;
+    } else {
+        if (!parse_number(colon1 + 1, last, stop))
+            return false;
+    }
+
+    if (is_geometric) {
+        if (step < 2 || start == 0)
+            return false;
+        for (std::size_t value = start; value <= stop; value *= step) {
+            values.push_back(SweepValue(value));
+            if (value > stop / step)
+                break;
+        }
+    } else {
+        if (step == 0)
+            return false;
+        for (std::size_t value = start; value <= stop; value += step) {
+            values.push_back(SweepValue(value));
+            if (stop - value < step)
+                break;
+        }
+    }
+    return true;
+}
+
+static bool parse_range(const char * text, std::vector<SweepValue> & values, bool allow_percent = false)
+{
+    values.clear();
+    const char * first = text;
+    const char * end = text + ::strlen(text);
+    while (first < end) {
+        const char * comma = (const char *)::memchr(first, ',', end - first);
+        const char * last = (comma != nullptr) ? comma : end;
+        if (!parse_range_item(first, last, values, allow_percent))
+            return false;
+        first = last + 1;
+    }
+    return !values.empty();
+}
+
+static void parse_list(const char * text, std::vector<std::string> & items)
+{
+    items.clear();
+    std::string list(text);
+    std::size_t first = 0;
+    while (first <= list.size()) {
+        std::size_t comma = list.find(',', first);
+        if (comma == std::string::npos)
+            comma = list.size();
+        if (comma > first)
+            items.push_back(list.substr(first, comma - first));
+        first = comma + 1;
+    }
+}
+
+static void print_bench_usage(const char * program)
+{
+    printf("Usage: %s [options]\n\n", program);
+    printf("  Without options, run the default validation and benchmark.\n\n");
+    printf("  --sweep              Run the parameter sweep with the default ranges.\n");
+    printf("  --latency            Run the small rotation latency suite (8 bytes -- 64 KB, ns/op).\n");
+    printf("  --divide             Run the batch division suite: fast_div_batch / fast_mod_batch\n");
+    printf("                       vs the scalar fast_div_u32 and the hardware div (ns/elem).\n");
+    printf("  --length=RANGE       Array lengths (elements), default: 100M (100K in Debug).\n");
+    printf("  --offset=RANGE       Rotate offsets (elements or N%% of length).\n");
+    printf("  --elem-size=LIST     Element sizes in bytes: 1, 2, 4, 8, 16, default: 4.\n");
+    printf("  --align=LIST         Buffer misalignment in bytes (from 64 bytes), default: 0.\n");
+    printf("  --algo=LIST          Algorithms or \"all\", default: the same as without options.\n");
+    printf("                       std::rotate, std_rotate, rotate, kerbal::rotate, libcxx_rotate,\n");
+    printf("                       fastmod_cycle_rotate, interleaved_cycle_rotate<8>,\n");
+    printf("                       simd::rotate, simd::rotate_reversal\n");
+    printf("  --reps=N             Repetitions per point, default: 5.\n");
+    printf("  --warmup=N           Untimed runs per point, default: 1.\n");
+    printf("  --format=FORMAT      text, json or csv, default: text.\n");
+    printf("  --output=FILE        Write the results to FILE, default: stdout.\n");
+    printf("  --roofline           Also time memcpy, memmove and the AVX copy kernel of each\n");
+    printf("                       size, report each rotation as a fraction of the fastest.\n");
+    printf("  --perf               Count cycles, instructions, L1D/LLC/dTLB misses and\n");
+    printf("                       branch-misses, report IPC and misses per KB (Linux only).\n");
+    printf("  --cpu=N              Pin the benchmark thread to cpu N.\n");
+    printf("  --cache=MODE         The cache state before each timed run: warm (read the array\n");
+    printf("                       once), cold (flush the array) or none, default: warm.\n");
+    printf("  --settle             Wait for a stable CPU frequency before each timed run.\n");
+    printf("  --help               Show this help.\n\n");
+    printf("  The isolation options (--cpu, --cache, --settle) also apply to the default run.\n\n");
+    printf("  RANGE: 100M | 1,7,33 | 1K:1M:*2 | 0:256:+32 | 50%% (offsets only)\n\n");
+}
+
+//
+// Returns false if there is any bad option, the error is printed to stderr.
+//
+static bool parse_bench_options(int argc, char * argv[], BenchOptions & options)
+{
+    for (int i = 1; i < argc; i++) {
+        const char * arg = argv[i];
+        const char * value = ::strchr(arg, '=');
+        std::string name = (value != nullptr) ? std::string(arg, value - arg) : std::string(arg);
+        if (value != nullptr)
+            value++;
+
+        bool ok = true;
+        if (name == "--help" || name == "-h") {
+            options.help = true;
+        } else if (name == "--sweep") {
+            options.sweep = true;
+        } else if (name == "--latency") {
+            options.latency = true;
+        } else if (name == "--divide") {
+            options.divide = true;
+        } else if (name == "--roofline") {
+            options.roofline = true;
+            options.sweep = true;
+        } else if (name == "--perf") {
+            options.perf = true;
+            options.sweep = true;
+        } else if (name == "--settle") {
+            options.settle = true;
+        } else if (value == nullptr) {
+            ok = false;
+        } else if (name == "--cpu") {
+            std::size_t cpu;
+            ok = parse_number(value, value + ::strlen(value), cpu) && (cpu < 4096);
+            options.cpu = (int)cpu;
+        } else if (name == "--cache") {
+            std::string cache(value);
+            if (cache == "warm")
+                options.cache = CacheWarm;
+            else if (cache == "cold")
+                options.cache = CacheCold;
+            else if (cache == "none")
+                options.cache = CacheNone;
+            else
+                ok = false;
+        } else if (name == "--length") {
+            ok = parse_range(value, options.lengths);
+            options.sweep = true;
+        } else if (name == "--offset") {
+            ok = parse_range(value, options.offsets, true);
+            options.sweep = true;
+        } else if (name == "--elem-size") {
+            ok = parse_range(value, options.elem_sizes);
+            options.sweep = true;
+        } else if (name == "--align") {
+            ok = parse_range(value, options.alignments);
+            options.sweep = true;
+        } else if (name == "--algo") {
+            parse_list(value, options.algorithms);
+            options.sweep = true;
+        } else if (name == "--reps") {
+            ok = parse_number(value, value + ::strlen(value), options.repeats) && (options.repeats > 0);
+            options.sweep = true;
+        } else if (name == "--warmup") {
+            ok = parse_number(value, value + ::strlen(value), options.warmups);
+            options.sweep = true;
+        } else if (name == "--format") {
+            std::string format(value);
+            if (format == "text")
+                options.format = OutputText;
+            else if (format == "json")
+                options.format = OutputJson;
+            else if (format == "csv")
+                options.format = OutputCsv;
+            else
+                ok = false;
+            options.sweep = true;
+        } else if (name == "--output") {
+            options.output = value;
+            options.sweep = true;
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            fprintf(stderr, "Error: bad option: %s\n\n", arg);
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace test
+
+#endif // JSTD_TEST_BENCH_OPTIONS_H
@@ -0,0 +1,338 @@
+
+#ifndef JSTD_TEST_BENCH_REPORT_H
+#define JSTD_TEST_BENCH_REPORT_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <inttypes.h>
+
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "BenchOptions.h"
+#include "PerfCounter.h"
+
+//
+// Statistics of the repetitions of one sweep point, and the text/JSON/CSV writer.
+//
+// JSON: { "benchmark": "rotate", "compiler": "...", "results": [ { one point per line }, ... ] }
+// CSV:  a header line, then one point per line.
+//
+// GB/s is the array bytes (length * elem_size) rotated per second at the median time.
+//
+// With the roofline (--roofline), each point has the fraction of the copy speed of
+// light of its size, see Roofline.h.
+//
+// With the hardware counters (--perf), each point also has the IPC and the misses
+// per KB of the array bytes, averaged over the repetitions. A counter that isn't
+// available is "n/a" in text, null in JSON and an empty field in CSV.
+//
+
+namespace test {
+
+struct BenchStats {
+    std::size_t count;
+    double      min;
+    double      median;
+    double      p90;
+    double      mean;
+
+    BenchStats() : count(0), min(0.0), median(0.0), p90(0.0), mean(0.0) {}
+};
+
+// Nearest-rank percentiles, the samples are in milliseconds.
+static BenchStats compute_bench_stats(std::vector<double> samples)
+{
+    BenchStats stats;
+    if (samples.empty())
+        return stats;
+
+    std::sort(samples.begin(), samples.end());
+    std::size_t count = samples.size();
+
+    double sum = 0.0;
+    for (std::size_t i = 0; i < count; i++) {
+        sum += samples[i];
+    }
+
+    stats.count = count;
+    stats.min = samples[0];
+    if ((count & 1) != 0)
+        stats.median = samples[count / 2];
+    else
+        stats.median = (samples[count / 2 - 1] + samples[count / 2]) * 0.5;
+    std::size_t p90_rank = (count * 90 + 99) / 100;
+    stats.p90 = samples[(p90_rank > 0) ? (p90_rank - 1) : 0];
+    stats.mean = sum / (double)count;
+    return stats;
+}
+
+struct BenchResult {
+    std::string algorithm;
+    std::size_t elem_size;
+    std::size_t length;
+    std::size_t offset;
+    std::size_t align;
+    BenchStats  stats;
+    // Fraction of the copy speed of light, < 0 if not measured.
+    double      roofline;
+    bool        has_counters;
+    // Per rotation, < 0 if the counter is not available.
+    double      counters[PerfCounterGroup::EventLast];
+
+    BenchResult() : elem_size(0), length(0), offset(0), align(0), roofline(-1.0), has_counters(false) {
+        for (int event = 0; event < PerfCounterGroup::EventLast; event++) {
+            this->counters[event] = -1.0;
+        }
+    }
+
+    double gbps() const {
+        if (this->stats.median <= 0.0)
+            return 0.0;
+        double bytes = (double)this->length * (double)this->elem_size;
+        return (bytes / (this->stats.median / 1000.0) / 1.0E9);
+    }
+
+    // Instructions per cycle, < 0 if not available.
+    double ipc() const {
+        double cycles = this->counters[PerfCounterGroup::Cycles];
+        double instructions = this->counters[PerfCounterGroup::Instructions];
+        if (cycles <= 0.0 || instructions < 0.0)
+            return -1.0;
+        return (instructions / cycles);
+    }
+
+    // Events per KB of the array bytes, < 0 if not available.
+    double per_kb(PerfCounterGroup::Event event) const {
+        double bytes = (double)this->length * (double)this->elem_size;
+        if (this->counters[event] < 0.0 || bytes <= 0.0)
+            return -1.0;
+        return (this->counters[event] * 1024.0 / bytes);
+    }
+};
+
+class BenchReport {
+private:
+    FILE *          fp_;
+    bool            owns_file_;
+    OutputFormat    format_;
+    std::size_t     count_;
+    bool            with_roofline_;
+    bool            with_counters_;
+
+    static const int kCounterColumns = 5;
+
+public:
+    BenchReport() : fp_(stdout), owns_file_(false), format_(OutputText), count_(0),
+                    with_roofline_(false), with_counters_(false) {}
+
+    ~BenchReport() {
+        this->close();
+    }
+
+    bool open(const std::string & filename, OutputFormat format,
+              bool with_roofline = false, bool with_counters = false) {
+        this->close();
+        this->format_ = format;
+        this->count_ = 0;
+        this->with_roofline_ = with_roofline;
+        this->with_counters_ = with_counters;
+        if (filename.empty()) {
+            this->fp_ = stdout;
+            this->owns_file_ = false;
+        } else {
+            this->fp_ = fopen(filename.c_str(), "wb");
+            if (this->fp_ == nullptr) {
+                this->fp_ = stdout;
+                return false;
+            }
+            this->owns_file_ = true;
+        }
+        return true;
+    }
+
+    void close() {
+        if (this->owns_file_ && this->fp_ != nullptr) {
+            fclose(this->fp_);
+        }
+        this->fp_ = stdout;
+        this->owns_file_ = false;
+    }
+
+    void begin() {
+        if (this->format_ == OutputJson) {
+            fprintf(this->fp_, "{\n");
+            fprintf(this->fp_, "  \"benchmark\": \"rotate\",\n");
+            fprintf(this->fp_, "  \"compiler\": \"%s\",\n", compiler_name());
+            fprintf(this->fp_, "  \"results\": [\n");
+        } else if (this->format_ == OutputCsv) {
+            fprintf(this->fp_, "algorithm,elem_size,length,offset,align,reps,"
+                               "min_ms,median_ms,p90_ms,mean_ms,gbps");
+            if (this->with_roofline_)
+                fprintf(this->fp_, ",roofline");
+            if (this->with_counters_) {
+                for (int column = 0; column < kCounterColumns; column++) {
+                    fprintf(this->fp_, ",%s", counter_key(column));
+                }
+            }
+            fprintf(this->fp_, "\n");
+        } else {
+            fprintf(this->fp_, " %-28s %5s %12s %12s %5s %10s %10s %10s %8s",
+                    "algorithm", "elem", "length", "offset", "align",
+                    "min(ms)", "median(ms)", "p90(ms)", "GB/s");
+            if (this->with_roofline_)
+                fprintf(this->fp_, " %6s", "SoL");
+            if (this->with_counters_) {
+                for (int column = 0; column < kCounterColumns; column++) {
+                    fprintf(this->fp_, " %9s", counter_title(column));
+                }
+            }
+            fprintf(this->fp_, "\n");
+        }
+        fflush(this->fp_);
+    }
+
+    void add(const BenchResult & result) {
+        const BenchStats & stats = result.stats;
+        if (this->format_ == OutputJson) {
+            fprintf(this->fp_, "%s    { \"algorithm\": \"%s\", \"elem_size\": %u, \"length\": %" PRIu64 ", "
+                               "\"offset\": %" PRIu64 ", \"align\": %u, \"reps\": %u, "
+                               "\"min_ms\": %.6f, \"median_ms\": %.6f, \"p90_ms\": %.6f, "
+                               "\"mean_ms\": %.6f, \"gbps\": %.4f",
+                    (this->count_ != 0) ? ",\n" : "",
+                    result.algorithm.c_str(), (uint32_t)result.elem_size,
+                    (uint64_t)result.length, (uint64_t)result.offset,
+                    (uint32_t)result.align, (uint32_t)stats.count,
+                    stats.min, stats.median, stats.p90, stats.mean, result.gbps());
+            if (this->with_roofline_) {
+                if (result.roofline >= 0.0)
+                    fprintf(this->fp_, ", \"roofline\": %.4f", result.roofline);
+                else
+                    fprintf(this->fp_, ", \"roofline\": null");
+            }
+            if (this->with_counters_) {
+                for (int column = 0; column < kCounterColumns; column++) {
+                    double value = counter_value(result, column);
+                    if (value >= 0.0)
+                        fprintf(this->fp_, ", \"%s\": %.4f", counter_key(column), value);
+                    else
+                        fprintf(this->fp_, ", \"%s\": null", counter_key(column));
+                }
+            }
+            fprintf(this->fp_, " }");
+        } else if (this->format_ == OutputCsv) {
+            fprintf(this->fp_, "%s,%u,%" PRIu64 ",%" PRIu64 ",%u,%u,%.6f,%.6f,%.6f,%.6f,%.4f",
+                    result.algorithm.c_str(), (uint32_t)result.elem_size,
+                    (uint64_t)result.length, (uint64_t)result.offset,
+                    (uint32_t)result.align, (uint32_t)stats.count,
+                    stats.min, stats.median, stats.p90, stats.mean, result.gbps());
+            if (this->with_roofline_) {
+                if (result.roofline >= 0.0)
+                    fprintf(this->fp_, ",%.4f", result.roofline);
+                else
+                    fprintf(this->fp_, ",");
+            }
+            if (this->with_counters_) {
+                for (int column = 0; column < kCounterColumns; column++) {
+                    double value = counter_value(result, column);
+                    if (value >= 0.0)
+                        fprintf(this->fp_, ",%.4f", value);
+                    else
+                        fprintf(this->fp_, ",");
+                }
+            }
+            fprintf(this->fp_, "\n");
+        } else {
+            fprintf(this->fp_, " %-28s %5u %12" PRIu64 " %12" PRIu64 " %5u %10.3f %10.3f %10.3f %8.2f",
+                    result.algorithm.c_str(), (uint32_t)result.elem_size,
+                    (uint64_t)result.length, (uint64_t)result.offset,
+                    (uint32_t)result.align, stats.min, stats.median, stats.p90, result.gbps());
+            if (this->with_roofline_) {
+                if (result.roofline >= 0.0)
+                    fprintf(this->fp_, " %5.1f%%", result.roofline * 100.0);
+                else
+                    fprintf(this->fp_, " %6s", "n/a");
+            }
+            if (this->with_counters_) {
+                for (int column = 0; column < kCounterColumns; column++) {
+                    double value = counter_value(result, column);
+                    if (value >= 0.0)
+                        fprintf(this->fp_, " %9.3f", value);
+                    else
+                        fprintf(this->fp_, " %9s", "n/a");
+                }
+            }
+            fprintf(this->fp_, "\n");
+        }
+        fflush(this->fp_);
+        this->count_++;
+    }
+
+    void end() {
+        if (this->format_ == OutputJson) {
+            fprintf(this->fp_, "%s  ]\n}\n", (this->count_ != 0) ? "\n" : "");
+        } else if (this->format_ == OutputText) {
+            fprintf(this->fp_, "\n");
+        }
+        fflush(this->fp_);
+    }
+
+private:
+    // The counter columns: IPC, then L1D, LLC, dTLB and branch misses per KB.
+    static const char * counter_key(int column) {
+        static const char * const kCounterKeys[kCounterColumns] = {
+            "ipc", "l1d_miss_per_kb", "llc_miss_per_kb", "dtlb_miss_per_kb", "branch_miss_per_kb"
+        };
+        return kCounterKeys[column];
+    }
+
+    static const char * counter_title(int column) {
+        static const char * const kCounterTitles[kCounterColumns] = {
+            "IPC", "L1D/KB", "LLC/KB", "dTLB/KB", "BrMiss/KB"
+        };
+        return kCounterTitles[column];
+    }
+
+    static double counter_value(const BenchResult & result, int column) {
+        if (!result.has_counters)
+            return -1.0;
+        switch (column) {
+            case 0:
+                return result.ipc();
+            case 1:
+                return result.per_kb(PerfCounterGroup::L1DMisses);
+            case 2:
+                return result.per_kb(PerfCounterGroup::LLCMisses);
+            case 3:
+                return result.per_kb(PerfCounterGroup::DTLBMisses);
+            case 4:
+                return result.per_kb(PerfCounterGroup::BranchMisses);
+            default:
+                return -1.0;
+        }
+    }
+
+    static const char * compiler_name() {
+#if defined(__clang__)
+        return "clang " __clang_version__;
+#elif defined(__INTEL_COMPILER)
+        return "icc";
+#elif defined(__GNUC__)
+        return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+        return "msvc";
+#else
+        return "unknown";
+#endif
+    }
+};
+
+} // namespace test
+
+#endif // JSTD_TEST_BENCH_REPORT_H
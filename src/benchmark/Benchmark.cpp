@@ -21,10 +21,19 @@
 
 #include "CPUWarmUp.h"
 #include "StopWatch.h"
+#include "ItemTypes.h"
+#include "LatencyBench.h"
+#include "BenchIsolation.h"
+#include "PerfCounter.h"
+#include "Roofline.h"
+#include "BenchOptions.h"
+#include "BenchReport.h"
 
 #include "jstd/ArrayRotate.h"
 #include "jstd/ArrayRotate_v1.h"
 #include "jstd/ArrayRotate_SIMD.h"
+#include "jstd/ArrayRotate_Calibrate.h"
+#include "jstd/FastDivBatch.h"
 
 extern void print_marcos();
 
@@ -34,6 +43,9 @@ extern void print_marcos();
 #endif
 #endif // USE_KERBAL_ROTATE
 
+// The cache state and CPU of each timed run, see main().
+static test::BenchIsolation bench_isolation;
+
 template <typename Container>
 int verify_array(Container & container1, Container & container2)
 {
@@ -61,7 +73,7 @@ void run_rotate_validate(Container & array_std, Container & array)
     //////////////////////////////////////////////////////////////
 
     for (size_t i = 0; i < length; i++) {
-        array_std[i] = (int)i;
+        array_std[i] = test::item_traits<ItemType>::make(i);
     }
 
     std::rotate(array_std.begin(), array_std.begin() + offset, array_std.end());
@@ -69,7 +81,7 @@ void run_rotate_validate(Container & array_std, Container & array)
     //////////////////////////////////////////////////////////////
 #if 1
     for (size_t i = 0; i < length; i++) {
-        array[i] = (int)i;
+        array[i] = test::item_traits<ItemType>::make(i);
     }
 
     jstd::std_rotate(array.begin(), array.begin() + offset, array.end());
@@ -85,7 +97,7 @@ void run_rotate_validate(Container & array_std, Container & array)
     //////////////////////////////////////////////////////////////
 
     for (size_t i = 0; i < length; i++) {
-        array[i] = (int)i;
+        array[i] = test::item_traits<ItemType>::make(i);
     }
 
     jstd::rotate(array.begin(), array.begin() + offset, array.end());
@@ -103,7 +115,7 @@ void run_rotate_validate(Container & array_std, Container & array)
 #if USE_KERBAL_ROTATE
 #if !defined(_MSC_VER) || (defined(_MSC_VER) && (_MSC_VER >= 2000))
     for (size_t i = 0; i < length; i++) {
-        array[i] = (int)i;
+        array[i] = test::item_traits<ItemType>::make(i);
     }
 
     kerbal::algorithm::rotate(array.begin(), array.begin() + offset, array.end());
@@ -121,7 +133,7 @@ void run_rotate_validate(Container & array_std, Container & array)
     //////////////////////////////////////////////////////////////
 
     for (size_t i = 0; i < length; i++) {
-        array[i] = (int)i;
+        array[i] = test::item_traits<ItemType>::make(i);
     }
 
     jstd::simd::rotate(&array[0], &array[0] + offset, &array[0] + array.size());
@@ -136,6 +148,54 @@ void run_rotate_validate(Container & array_std, Container & array)
 
     //////////////////////////////////////////////////////////////
 
+    for (size_t i = 0; i < length; i++) {
+        array[i] = test::item_traits<ItemType>::make(i);
+    }
+
+    jstd::simd::rotate_reversal(&array[0], &array[0] + offset, &array[0] + array.size());
+
+    printf(" jstd::simd::rotate_reversal(%u, %2u): ", (uint32_t)length, (uint32_t)offset);
+    error_pos = verify_array(array, array_std);
+    if (error_pos == -1)
+        printf("Pass");
+    else
+        printf("Failed (pos = %d)", error_pos);
+    printf("\n");
+
+    //////////////////////////////////////////////////////////////
+
+    for (size_t i = 0; i < length; i++) {
+        array[i] = test::item_traits<ItemType>::make(i);
+    }
+
+    jstd::interleaved_cycle_rotate<8>(array.begin(), array.begin() + offset, array.end());
+
+    printf(" jstd::interleaved_cycle_rotate<8>(%u, %2u): ", (uint32_t)length, (uint32_t)offset);
+    error_pos = verify_array(array, array_std);
+    if (error_pos == -1)
+        printf("Pass");
+    else
+        printf("Failed (pos = %d)", error_pos);
+    printf("\n");
+
+    //////////////////////////////////////////////////////////////
+
+    for (size_t i = 0; i < length; i++) {
+        array[i] = test::item_traits<ItemType>::make(i);
+    }
+
+    jstd::fastmod_cycle_rotate(array.begin(), array.begin() + offset, array.end());
+
+    printf(" jstd::fastmod_cycle_rotate(%u, %2u): ", (uint32_t)length, (uint32_t)offset);
+    error_pos = verify_array(array, array_std);
+    if (error_pos == -1)
+        printf("Pass");
+    else
+        printf("Failed (pos = %d)", error_pos);
+    printf("\n");
+
+    //////////////////////////////////////////////////////////////
+
     printf("\n");
 }
 
@@ -146,6 +206,9 @@ void run_rotate_benchmark(Container & array)
     static const std::size_t length = (Length <= 0) ? 100000000 : Length;
     static const std::size_t offset = Offset % length;
 
+    const void * data = &array[0];
+    std::size_t bytes = array.size() * sizeof(ItemType);
+
     test::StopWatch sw;
     double elapsedTime;
 
@@ -153,6 +216,7 @@ void run_rotate_benchmark(Container & array)
 
     //////////////////////////////////////////////////////////////
 
+    bench_isolation.prepare(data, bytes);
     sw.start();
     std::rotate(array.begin(), array.begin() + offset, array.end());
     sw.stop();
@@ -162,6 +226,7 @@ void run_rotate_benchmark(Container & array)
 
     //////////////////////////////////////////////////////////////
 
+    bench_isolation.prepare(data, bytes);
     sw.start();
     jstd::std_rotate(array.begin(), array.begin() + offset, array.end());
     sw.stop();
@@ -171,6 +236,7 @@ void run_rotate_benchmark(Container & array)
 
     //////////////////////////////////////////////////////////////
 
+    bench_isolation.prepare(data, bytes);
     sw.start();
     jstd::rotate(array.begin(), array.begin() + offset, array.end());
     sw.stop();
@@ -182,6 +248,7 @@ void run_rotate_benchmark(Container & array)
 
 #if USE_KERBAL_ROTATE
 #if !defined(_MSC_VER) || (defined(_MSC_VER) && (_MSC_VER >= 2000))
+    bench_isolation.prepare(data, bytes);
     sw.start();
     kerbal::algorithm::rotate(array.begin(), array.begin() + offset, array.end());
     sw.stop();
@@ -193,6 +260,7 @@ void run_rotate_benchmark(Container & array)
 
     //////////////////////////////////////////////////////////////
 
+    bench_isolation.prepare(data, bytes);
     sw.start();
     jstd::simd::rotate(&array[0], &array[0] + offset, &array[0] + array.size());
     sw.stop();
@@ -200,6 +268,16 @@ void run_rotate_benchmark(Container & array)
     elapsedTime = sw.getElapsedMillisec();
     printf(" jstd::simd::rotate(%u, %2u):        %0.2f ms\n", (uint32_t)length, (uint32_t)offset, elapsedTime);
 
+    //////////////////////////////////////////////////////////////
+
+    bench_isolation.prepare(data, bytes);
+    sw.start();
+    jstd::simd::rotate_reversal(&array[0], &array[0] + offset, &array[0] + array.size());
+    sw.stop();
+
+    elapsedTime = sw.getElapsedMillisec();
+    printf(" jstd::simd::rotate_reversal(%u, %2u): %0.2f ms\n", (uint32_t)length, (uint32_t)offset, elapsedTime);
+
     printf("\n");
     //////////////////////////////////////////////////////////////
 }
@@ -277,14 +355,898 @@ void rotate_benchmark()
     printf("//////////////////////////////////////////////////////////////////\n\n");
 }
 
+//
+// The type matrix: the same validation and benchmark over the element types
+// of test/ItemTypes.h, the non-power-of-2 sizes (12, 24 bytes) and std::string
+// cover the kValueSizeIsDivisible = false paths and the generic fallbacks.
+//
+template <typename ItemType>
+void rotate_validate_type()
+{
+    // Not a multiple of any vector size, so every kernel has a tail.
+    static const size_t test_length = 100003;
+
+    std::vector<ItemType> array_std;
+    array_std.resize(test_length);
+
+    std::vector<ItemType> array;
+    array.resize(test_length);
+
+    printf(" Type: %s (%u bytes)\n\n", test::item_traits<ItemType>::name(), (uint32_t)sizeof(ItemType));
+
+    run_rotate_validate<ItemType, test_length, 1>(array_std, array);
+    run_rotate_validate<ItemType, test_length, 3>(array_std, array);
+    run_rotate_validate<ItemType, test_length, 7>(array_std, array);
+    run_rotate_validate<ItemType, test_length, 33>(array_std, array);
+    run_rotate_validate<ItemType, test_length, 150>(array_std, array);
+    run_rotate_validate<ItemType, test_length, 1000>(array_std, array);
+    run_rotate_validate<ItemType, test_length, test_length / 3>(array_std, array);
+    run_rotate_validate<ItemType, test_length, test_length / 2>(array_std, array);
+    run_rotate_validate<ItemType, test_length, test_length - 5>(array_std, array);
+}
+
+template <typename ItemType>
+void rotate_benchmark_type()
+{
+    // The same bytes for all types.
+#if defined(NDEBUG)
+    static const size_t test_length = (64 * 1024 * 1024) / sizeof(ItemType);
+#else
+    static const size_t test_length = (256 * 1024) / sizeof(ItemType);
+#endif
+
+    std::vector<ItemType> array;
+    array.resize(test_length);
+    for (size_t i = 0; i < test_length; i++) {
+        array[i] = test::item_traits<ItemType>::make(i);
+    }
+
+    printf(" Type: %s (%u bytes)\n\n", test::item_traits<ItemType>::name(), (uint32_t)sizeof(ItemType));
+
+    run_rotate_benchmark<ItemType, test_length, 1>(array);
+    run_rotate_benchmark<ItemType, test_length, 33>(array);
+    run_rotate_benchmark<ItemType, test_length, 1000>(array);
+    run_rotate_benchmark<ItemType, test_length, test_length / 3>(array);
+}
+
+void rotate_type_matrix_validate()
+{
+    rotate_validate_type<uint8_t>();
+    rotate_validate_type<uint16_t>();
+    rotate_validate_type<uint64_t>();
+    rotate_validate_type<test::item12>();
+    rotate_validate_type<test::item16>();
+    rotate_validate_type<test::item24>();
+    rotate_validate_type<std::string>();
+
+    printf("--------------------------------------------------------------\n\n");
+}
+
+void rotate_type_matrix_benchmark()
+{
+    rotate_benchmark_type<uint8_t>();
+    rotate_benchmark_type<uint16_t>();
+    rotate_benchmark_type<uint64_t>();
+    rotate_benchmark_type<test::item12>();
+    rotate_benchmark_type<test::item16>();
+    rotate_benchmark_type<test::item24>();
+    rotate_benchmark_type<std::string>();
+
+    printf("//////////////////////////////////////////////////////////////////\n\n");
+}
+
+//
+// Sweep the offset at runtime, to show where the interleaved cycle rotation
+// beats the swap (jstd::rotate) and the stash (jstd::simd::rotate) approaches.
+//
+void rotate_offset_sweep()
+{
+#if defined(NDEBUG)
+    static const size_t test_length = 100000000;
+#else
+    static const size_t test_length = 100000;
+#endif
+
+    static const size_t offsets[] = {
+        1, 3, 8, 33, 150, 512, 1000, 4096, 9810, 65536, 1000003,
+        test_length / 64, test_length / 8 + 1, test_length / 3, test_length / 2 - 1
+    };
+
+    std::vector<int> array;
+    array.resize(test_length);
+    for (size_t i = 0; i < test_length; i++) {
+        array[i] = (int)i;
+    }
+
+    const void * data = &array[0];
+    std::size_t bytes = array.size() * sizeof(int);
+
+    test::StopWatch sw;
+
+    printf(" Offset sweep (length = %u, unit: ms)\n\n", (uint32_t)test_length);
+    printf(" %10s %12s %12s %12s %12s %12s %12s\n",
+           "offset", "libcxx", "cycle<4>", "cycle<8>", "cycle<16>", "jstd::rotate", "simd::rotate");
+
+    for (size_t n = 0; n < sizeof(offsets) / sizeof(offsets[0]); n++) {
+        std::size_t offset = offsets[n] % test_length;
+        double elapsedTime[6];
+
+        bench_isolation.prepare(data, bytes);
+        sw.start();
+        jstd::libcxx_rotate(array.begin(), array.begin() + offset, array.end());
+        sw.stop();
+        elapsedTime[0] = sw.getElapsedMillisec();
+
+        bench_isolation.prepare(data, bytes);
+        sw.start();
+        jstd::interleaved_cycle_rotate<4>(array.begin(), array.begin() + offset, array.end());
+        sw.stop();
+        elapsedTime[1] = sw.getElapsedMillisec();
+
+        bench_isolation.prepare(data, bytes);
+        sw.start();
+        jstd::interleaved_cycle_rotate<8>(array.begin(), array.begin() + offset, array.end());
+        sw.stop();
+        elapsedTime[2] = sw.getElapsedMillisec();
+
+        bench_isolation.prepare(data, bytes);
+        sw.start();
+        jstd::interleaved_cycle_rotate<16>(array.begin(), array.begin() + offset, array.end());
+        sw.stop();
+        elapsedTime[3] = sw.getElapsedMillisec();
+
+        bench_isolation.prepare(data, bytes);
+        sw.start();
+        jstd::rotate(array.begin(), array.begin() + offset, array.end());
+        sw.stop();
+        elapsedTime[4] = sw.getElapsedMillisec();
+
+        bench_isolation.prepare(data, bytes);
+        sw.start();
+        jstd::simd::rotate(&array[0], &array[0] + offset, &array[0] + array.size());
+        sw.stop();
+        elapsedTime[5] = sw.getElapsedMillisec();
+
+        printf(" %10u %12.2f %12.2f %12.2f %12.2f %12.2f %12.2f\n", (uint32_t)offset,
+               elapsedTime[0], elapsedTime[1], elapsedTime[2],
+               elapsedTime[3], elapsedTime[4], elapsedTime[5]);
+    }
+
+    printf("\n");
+    printf("//////////////////////////////////////////////////////////////////\n\n");
+}
+
+template <typename T>
+void latency_std_rotate(T * first, T * mid, T * last)
+{
+    std::rotate(first, mid, last);
+}
+
+template <typename T>
+void latency_jstd_rotate(T * first, T * mid, T * last)
+{
+    jstd::rotate(first, mid, last);
+}
+
+#if USE_KERBAL_ROTATE
+#if !defined(_MSC_VER) || (defined(_MSC_VER) && (_MSC_VER >= 2000))
+template <typename T>
+void latency_kerbal_rotate(T * first, T * mid, T * last)
+{
+    kerbal::algorithm::rotate(first, mid, last);
+}
+#endif
+#endif // USE_KERBAL_ROTATE
+
+template <typename T>
+void latency_simd_rotate(T * first, T * mid, T * last)
+{
+    jstd::simd::rotate(first, mid, last);
+}
+
+//
+// The kernel of jstd::simd::rotate() for the (length, offset), see RotatePath.
+//
+template <typename T>
+const char * simd_rotate_path(std::size_t length, std::size_t offset)
+{
+    return jstd::simd::rotate_path_name(jstd::simd::get_rotate_path<T>(offset, length - offset));
+}
+
+//
+// Latency (ns/op) of the small rotations, the buffer is hot in cache.
+// For each length, the offsets hit the SSE stash and each AVX stash size
+// (1 -- 12 regs) of jstd::simd::rotate().
+//
+void rotate_latency_benchmark()
+{
+    typedef int item_type;
+
+    static const std::size_t kMinBytes = 8;
+    static const std::size_t kMaxBytes = 64 * 1024;
+    static const std::size_t kMaxLength = kMaxBytes / sizeof(item_type);
+
+    std::vector<std::size_t> stash_offsets;
+    // The SSE stash: 16 bytes at most.
+    stash_offsets.push_back(jstd::simd::kSSERegBytes / sizeof(item_type) - 1);
+    // The AVX stash of N regs: (32 * N - 4) bytes.
+    for (std::size_t regs = 1; regs <= 12; regs++) {
+        stash_offsets.push_back((regs * jstd::simd::kAVXRegBytes - sizeof(item_type)) / sizeof(item_type));
+    }
+
+    static const std::size_t kBufferAlignment = 64;
+
+    char * alloc_buffer = (char *)malloc(kMaxLength * sizeof(item_type) + kBufferAlignment);
+    if (alloc_buffer == nullptr)
+        return;
+    item_type * buffer = (item_type *)(((uintptr_t)alloc_buffer + kBufferAlignment - 1)
+                                       & ~(uintptr_t)(kBufferAlignment - 1));
+    for (std::size_t i = 0; i < kMaxLength; i++) {
+        buffer[i] = (item_type)i;
+    }
+
+    double overhead = test::measure_latency_overhead(buffer, buffer + 1, buffer + 2);
+
+#if HAVE_RDTSC_STOPWATCH
+    printf(" TSC: %0.3f GHz, %s\n\n", test::rdtscStopWatchImpl<double>::frequency() / 1.0E9,
+           test::rdtscStopWatchImpl<double>::is_invariant() ? "invariant" : "not invariant (the times are not reliable)");
+#endif
+
+    printf(" Small rotation latency (element = int, unit: ns/op, loop overhead %0.2f ns subtracted)\n\n",
+           overhead);
+    printf(" %8s %8s %8s %-12s %12s %12s %12s %12s\n",
+           "bytes", "length", "offset", "path",
+           "std::rotate", "jstd::rotate", "kerbal", "simd::rotate");
+
+    for (std::size_t bytes = kMinBytes; bytes <= kMaxBytes; bytes *= 2) {
+        std::size_t length = bytes / sizeof(item_type);
+
+        std::vector<std::size_t> offsets;
+        if (length * sizeof(item_type) <= jstd::simd::kAVXRotateThresholdBytes) {
+            offsets.push_back(1);
+            offsets.push_back(length / 2);
+        } else {
+            for (std::size_t n = 0; n < stash_offsets.size(); n++) {
+                if (stash_offsets[n] <= length / 2)
+                    offsets.push_back(stash_offsets[n]);
+            }
+        }
+        std::sort(offsets.begin(), offsets.end());
+        offsets.erase(std::unique(offsets.begin(), offsets.end()), offsets.end());
+
+        for (std::size_t n = 0; n < offsets.size(); n++) {
+            std::size_t offset = offsets[n];
+            if (offset == 0 || offset >= length)
+                continue;
+
+            item_type * first = buffer;
+            item_type * mid = buffer + offset;
+            item_type * last = buffer + length;
+
+            double latency[4];
+            latency[0] = test::measure_latency<item_type>(&latency_std_rotate<item_type>,
+                                                          first, mid, last, overhead);
+            latency[1] = test::measure_latency<item_type>(&latency_jstd_rotate<item_type>,
+                                                          first, mid, last, overhead);
+#if USE_KERBAL_ROTATE && (!defined(_MSC_VER) || (defined(_MSC_VER) && (_MSC_VER >= 2000)))
+            latency[2] = test::measure_latency<item_type>(&latency_kerbal_rotate<item_type>,
+                                                          first, mid, last, overhead);
+#else
+            latency[2] = -1.0;
+#endif
+            latency[3] = test::measure_latency<item_type>(&latency_simd_rotate<item_type>,
+                                                          first, mid, last, overhead);
+
+            printf(" %8u %8u %8u %-12s", (uint32_t)bytes, (uint32_t)length, (uint32_t)offset,
+                   simd_rotate_path<item_type>(length, offset));
+            for (int i = 0; i < 4; i++) {
+                if (latency[i] >= 0.0)
+                    printf(" %12.2f", latency[i]);
+                else
+                    printf(" %12s", "n/a");
+            }
+            printf("\n");
+        }
+    }
+
+    free(alloc_buffer);
+
+    printf("\n");
+    printf("//////////////////////////////////////////////////////////////////\n\n");
+}
+
+//
+// The cycle rotations step with a data-dependent branch (libcxx_rotate) or
+// with a modulo (fastmod_cycle_rotate), count the branch misses of each one
+// over some irregular offsets.
+//
+void rotate_branch_miss_benchmark()
+{
+#if defined(NDEBUG)
+    static const size_t test_length = 10000000;
+#else
+    static const size_t test_length = 100000;
+#endif
+
+    static const size_t offsets[] = {
+        3, 7, 33, 150, 1000, 9810, 65537, 1000003,
+        test_length / 3 + 1, test_length / 2 - 1, test_length * 2 / 3 + 7
+    };
+
+    std::vector<int> array;
+    array.resize(test_length);
+    for (size_t i = 0; i < test_length; i++) {
+        array[i] = (int)i;
+    }
+
+    const void * data = &array[0];
+    std::size_t bytes = array.size() * sizeof(int);
+
+    test::StopWatch sw;
+    test::PerfCounter branch_misses(test::PerfCounter::BranchMisses);
+
+    printf(" Branch misses of cycle rotation (length = %u, time unit: ms)\n\n", (uint32_t)test_length);
+    if (!branch_misses.is_valid()) {
+        printf(" (perf_event_open() is not available, the branch misses are n/a)\n\n");
+    }
+    printf(" %10s %12s %14s %12s %14s %12s %14s\n",
+           "offset", "libcxx", "misses", "std_rotate", "misses", "fastmod", "misses");
+
+    for (size_t n = 0; n < sizeof(offsets) / sizeof(offsets[0]); n++) {
+        std::size_t offset = offsets[n] % test_length;
+        double elapsedTime[3];
+        uint64_t misses[3];
+
+        bench_isolation.prepare(data, bytes);
+        branch_misses.start();
+        sw.start();
+        jstd::libcxx_rotate(array.begin(), array.begin() + offset, array.end());
+        sw.stop();
+        branch_misses.stop();
+        elapsedTime[0] = sw.getElapsedMillisec();
+        misses[0] = branch_misses.value();
+
+        bench_isolation.prepare(data, bytes);
+        branch_misses.start();
+        sw.start();
+        jstd::std_rotate(array.begin(), array.begin() + offset, array.end());
+        sw.stop();
+        branch_misses.stop();
+        elapsedTime[1] = sw.getElapsedMillisec();
+        misses[1] = branch_misses.value();
+
+        bench_isolation.prepare(data, bytes);
+        branch_misses.start();
+        sw.start();
+        jstd::fastmod_cycle_rotate(array.begin(), array.begin() + offset, array.end());
+        sw.stop();
+        branch_misses.stop();
+        elapsedTime[2] = sw.getElapsedMillisec();
+        misses[2] = branch_misses.value();
+
+        if (branch_misses.is_valid()) {
+            printf(" %10u %12.2f %14" PRIu64 " %12.2f %14" PRIu64 " %12.2f %14" PRIu64 "\n",
+                   (uint32_t)offset,
+                   elapsedTime[0], misses[0], elapsedTime[1], misses[1],
+                   elapsedTime[2], misses[2]);
+        } else {
+            printf(" %10u %12.2f %14s %12.2f %14s %12.2f %14s\n",
+                   (uint32_t)offset,
+                   elapsedTime[0], "n/a", elapsedTime[1], "n/a",
+                   elapsedTime[2], "n/a");
+        }
+    }
+
+    printf("\n");
+    printf("//////////////////////////////////////////////////////////////////\n\n");
+}
+
+//
+// x[i] / d and x[i] % d over a whole array: the hardware div, the scalar
+// fast_div_u32 (the table below kMaxDivTable, else div) and fast_div_batch.
+//
+template <typename DivFunc>
+double divide_benchmark_time(DivFunc && func, std::size_t iterations)
+{
+    test::StopWatch sw;
+    func();
+    sw.start();
+    for (std::size_t n = 0; n < iterations; n++) {
+        func();
+    }
+    sw.stop();
+    return sw.getElapsedMillisec();
+}
+
+void fast_div_batch_benchmark()
+{
+#if defined(NDEBUG)
+    static const size_t test_length = 1024 * 1024;
+    static const size_t iterations = 20;
+#else
+    static const size_t test_length = 64 * 1024;
+    static const size_t iterations = 2;
+#endif
+
+    static const uint32_t divisors32[] = {
+        3, 7, 100, 511, 1000, 65537, 1000003, 0x7FFFFFFFul
+    };
+    static const uint64_t divisors64[] = {
+        3, 7, 1000, 1000003, 0x100000001ull, 10000000000000000019ull
+    };
+
+    std::vector<uint32_t> src32(test_length), dest32(test_length), check32(test_length);
+    std::vector<uint64_t> src64(test_length), dest64(test_length), check64(test_length);
+    uint64_t seed = 20240401ull;
+    for (size_t i = 0; i < test_length; i++) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        src64[i] = seed;
+        src32[i] = (uint32_t)(seed >> 32);
+    }
+
+    const double elements = (double)test_length * iterations;
+    printf(" Batch division (length = %u, time unit: ns/elem)\n\n", (uint32_t)test_length);
+    printf(" %-22s %-4s %10s %14s %14s %8s\n", "divisor", "op", "div", "fast_div_u32", "batch", "check");
+
+    for (size_t n = 0; n < sizeof(divisors32) / sizeof(divisors32[0]); n++) {
+        const uint32_t divisor = divisors32[n];
+        for (int op = 0; op < 2; op++) {
+            bool is_mod = (op != 0);
+            double hardware = divide_benchmark_time([&]() {
+                for (size_t i = 0; i < test_length; i++)
+                    check32[i] = is_mod ? (src32[i] % divisor) : (src32[i] / divisor);
+            }, iterations);
+            double scalar = divide_benchmark_time([&]() {
+                for (size_t i = 0; i < test_length; i++)
+                    dest32[i] = is_mod ? jstd::fast_mod_u32(src32[i], divisor) : jstd::fast_div_u32(src32[i], divisor);
+            }, iterations);
+            double batch = divide_benchmark_time([&]() {
+                if (is_mod)
+                    jstd::fast_mod_batch(src32.data(), dest32.data(), test_length, divisor);
+                else
+                    jstd::fast_div_batch(src32.data(), dest32.data(), test_length, divisor);
+            }, iterations);
+            bool ok = (dest32 == check32);
+            printf(" %-22u %-4s %10.3f %14.3f %14.3f %8s\n", divisor, (is_mod ? "mod" : "div"),
+                   hardware * 1000000.0 / elements, scalar * 1000000.0 / elements,
+                   batch * 1000000.0 / elements, (ok ? "ok" : "FAILED"));
+        }
+    }
+    printf("\n");
+
+    for (size_t n = 0; n < sizeof(divisors64) / sizeof(divisors64[0]); n++) {
+        const uint64_t divisor = divisors64[n];
+        for (int op = 0; op < 2; op++) {
+            bool is_mod = (op != 0);
+            double hardware = divide_benchmark_time([&]() {
+                for (size_t i = 0; i < test_length; i++)
+                    check64[i] = is_mod ? (src64[i] % divisor) : (src64[i] / divisor);
+            }, iterations);
+            double batch = divide_benchmark_time([&]() {
+                if (is_mod)
+                    jstd::fast_mod_batch(src64.data(), dest64.data(), test_length, divisor);
+                else
+                    jstd::fast_div_batch(src64.data(), dest64.data(), test_length, divisor);
+            }, iterations);
+            bool ok = (dest64 == check64);
+            printf(" %-22" PRIu64 " %-4s %10.3f %14s %14.3f %8s\n", divisor, (is_mod ? "mod" : "div"),
+                   hardware * 1000000.0 / elements, "-",
+                   batch * 1000000.0 / elements, (ok ? "ok" : "FAILED"));
+        }
+    }
+
+    printf("\n");
+    printf("//////////////////////////////////////////////////////////////////\n\n");
+}
+
+//
+// Calibrate the prefetch distance and hint level of the SIMD kernels at startup.
+//
+void rotate_calibrate()
+{
+    jstd::simd::RotateCalibrateResult result = jstd::simd::calibrate_rotate_params();
+
+    printf(" Prefetch calibration:\n\n");
+    printf(" default: offset = %4u, hint = %-4s  %8.3f ms\n",
+           (uint32_t)jstd::simd::kPrefetchOffset,
+           jstd::simd::prefetch_hint_name(jstd::simd::kPrefetchHintLevel),
+           result.default_time);
+    printf(" chosen:  offset = %4u, hint = %-4s  %8.3f ms\n",
+           (uint32_t)result.params.prefetch_offset,
+           jstd::simd::prefetch_hint_name(result.params.prefetch_hint),
+           result.best_time);
+    printf("\n");
+    printf("//////////////////////////////////////////////////////////////////\n\n");
+}
+
+//////////////////////////////////////////////////////////////////
+//
+// Parameter sweep (command line mode)
+//
+//////////////////////////////////////////////////////////////////
+
+enum SweepAlgorithm {
+    AlgoStdRotate,
+    AlgoJstdStdRotate,
+    AlgoJstdRotate,
+    AlgoKerbalRotate,
+    AlgoLibcxxRotate,
+    AlgoFastModCycleRotate,
+    AlgoInterleavedCycleRotate,
+    AlgoSimdRotate,
+    AlgoSimdRotateReversal,
+    AlgoLast
+};
+
+static const char * const kSweepAlgorithmNames[AlgoLast] = {
+    "std::rotate",
+    "jstd::std_rotate",
+    "jstd::rotate",
+    "kerbal::rotate",
+    "jstd::libcxx_rotate",
+    "jstd::fastmod_cycle_rotate",
+    "jstd::interleaved_cycle_rotate<8>",
+    "jstd::simd::rotate",
+    "jstd::simd::rotate_reversal"
+};
+
+// The algorithms of rotate_benchmark(), used when --algo is not given.
+static const int kDefaultSweepAlgorithms[] = {
+    AlgoStdRotate,
+    AlgoJstdStdRotate,
+    AlgoJstdRotate,
+#if USE_KERBAL_ROTATE
+    AlgoKerbalRotate,
+#endif
+    AlgoSimdRotate,
+    AlgoSimdRotateReversal
+};
+
+static bool sweep_algorithm_enabled(int algorithm)
+{
+#if !USE_KERBAL_ROTATE || (defined(_MSC_VER) && (_MSC_VER < 2000))
+    if (algorithm == AlgoKerbalRotate)
+        return false;
+#endif
+    return (algorithm >= 0 && algorithm < AlgoLast);
+}
+
+// Accept the full name, or the name without "jstd::" / "std::" prefix: e.g. "simd::rotate".
+static int find_sweep_algorithm(const std::string & name)
+{
+    for (int algorithm = 0; algorithm < AlgoLast; algorithm++) {
+        std::string full_name = kSweepAlgorithmNames[algorithm];
+        if (name == full_name)
+            return algorithm;
+        if (full_name.compare(0, 6, "jstd::") == 0 && name == full_name.substr(6))
+            return algorithm;
+    }
+    return -1;
+}
+
+template <typename T>
+void run_sweep_algorithm(int algorithm, T * first, T * mid, T * last)
+{
+    switch (algorithm) {
+        case AlgoStdRotate:
+            std::rotate(first, mid, last);
+            break;
+        case AlgoJstdStdRotate:
+            jstd::std_rotate(first, mid, last);
+            break;
+        case AlgoJstdRotate:
+            jstd::rotate(first, mid, last);
+            break;
+#if USE_KERBAL_ROTATE
+#if !defined(_MSC_VER) || (defined(_MSC_VER) && (_MSC_VER >= 2000))
+        case AlgoKerbalRotate:
+            kerbal::algorithm::rotate(first, mid, last);
+            break;
+#endif
+#endif // USE_KERBAL_ROTATE
+        case AlgoLibcxxRotate:
+            jstd::libcxx_rotate(first, mid, last);
+            break;
+        case AlgoFastModCycleRotate:
+            jstd::fastmod_cycle_rotate(first, mid, last);
+            break;
+        case AlgoInterleavedCycleRotate:
+            jstd::interleaved_cycle_rotate<8>(first, mid, last);
+            break;
+        case AlgoSimdRotate:
+            jstd::simd::rotate(first, mid, last);
+            break;
+        case AlgoSimdRotateReversal:
+            jstd::simd::rotate_reversal(first, mid, last);
+            break;
+        default:
+            break;
+    }
+}
+
+//
+// If perf is not null, the counters are read around each timed rotation,
+// the result has the average per rotation of the counted repetitions.
+//
+template <typename T>
+void run_sweep_point(const test::BenchOptions & options, int algorithm,
+                     char * buffer, std::size_t length, std::size_t offset,
+                     test::PerfCounterGroup * perf, test::BenchResult & result)
+{
+    T * first = (T *)buffer;
+    T * mid = first + offset;
+    T * last = first + length;
+
+    for (std::size_t i = 0; i < options.warmups; i++) {
+        run_sweep_algorithm(algorithm, first, mid, last);
+    }
+
+    std::vector<double> samples;
+    samples.reserve(options.repeats);
+
+    double counter_sums[test::PerfCounterGroup::EventLast] = { 0.0 };
+    std::size_t counted = 0;
+
+    test::StopWatch sw;
+    for (std::size_t i = 0; i < options.repeats; i++) {
+        bench_isolation.prepare(buffer, length * sizeof(T));
+        if (perf != nullptr)
+            perf->start();
+        sw.start();
+        run_sweep_algorithm(algorithm, first, mid, last);
+        sw.stop();
+        if (perf != nullptr)
+            perf->stop();
+        samples.push_back(sw.getElapsedMillisec());
+
+        if (perf != nullptr && perf->is_counted()) {
+            for (int event = 0; event < test::PerfCounterGroup::EventLast; event++) {
+                counter_sums[event] += (double)perf->value((test::PerfCounterGroup::Event)event);
+            }
+            counted++;
+        }
+    }
+
+    result.stats = test::compute_bench_stats(samples);
+
+    result.has_counters = (perf != nullptr);
+    if (perf != nullptr && counted > 0) {
+        for (int event = 0; event < test::PerfCounterGroup::EventLast; event++) {
+            if (perf->is_available((test::PerfCounterGroup::Event)event))
+                result.counters[event] = counter_sums[event] / (double)counted;
+        }
+    }
+}
+
+static bool run_sweep_elem_size(const test::BenchOptions & options, int algorithm,
+                                std::size_t elem_size, char * buffer,
+                                std::size_t length, std::size_t offset,
+                                test::PerfCounterGroup * perf, test::BenchResult & result)
+{
+    switch (elem_size) {
+        case 1:
+            run_sweep_point<uint8_t>(options, algorithm, buffer, length, offset, perf, result);
+            break;
+        case 2:
+            run_sweep_point<uint16_t>(options, algorithm, buffer, length, offset, perf, result);
+            break;
+        case 4:
+            run_sweep_point<uint32_t>(options, algorithm, buffer, length, offset, perf, result);
+            break;
+        case 8:
+            run_sweep_point<uint64_t>(options, algorithm, buffer, length, offset, perf, result);
+            break;
+        case 16:
+            run_sweep_point<test::item16>(options, algorithm, buffer, length, offset, perf, result);
+            break;
+        default:
+            return false;
+    }
+    return true;
+}
+
+//
+// Sweep length x offset x element size x alignment x algorithm,
+// each point runs options.repeats times.
+//
+int rotate_sweep(test::BenchOptions & options)
+{
+#if defined(NDEBUG)
+    static const size_t default_length = 100000000;
+#else
+    static const size_t default_length = 100000;
+#endif
+    static const size_t default_offsets[] = {
+        1, 2, 3, 4, 7, 8, 9, 10, 15, 32, 33, 65, 150, 280, 512, 600, 1000,
+        1500, 2000, 2973, 4908, 9810, 33333333, 50000000
+    };
+
+    if (options.lengths.empty()) {
+        options.lengths.push_back(test::SweepValue(default_length));
+    }
+    if (options.offsets.empty()) {
+        for (size_t i = 0; i < sizeof(default_offsets) / sizeof(default_offsets[0]); i++) {
+            options.offsets.push_back(test::SweepValue(default_offsets[i]));
+        }
+    }
+    if (options.elem_sizes.empty()) {
+        options.elem_sizes.push_back(test::SweepValue(sizeof(int)));
+    }
+    if (options.alignments.empty()) {
+        options.alignments.push_back(test::SweepValue(0));
+    }
+
+    std::vector<int> algorithms;
+    if (options.algorithms.empty()) {
+        for (size_t i = 0; i < sizeof(kDefaultSweepAlgorithms) / sizeof(kDefaultSweepAlgorithms[0]); i++) {
+            algorithms.push_back(kDefaultSweepAlgorithms[i]);
+        }
+    } else {
+        for (size_t i = 0; i < options.algorithms.size(); i++) {
+            if (options.algorithms[i] == "all") {
+                for (int algorithm = 0; algorithm < AlgoLast; algorithm++) {
+                    if (sweep_algorithm_enabled(algorithm))
+                        algorithms.push_back(algorithm);
+                }
+                continue;
+            }
+            int algorithm = find_sweep_algorithm(options.algorithms[i]);
+            if (algorithm < 0 || !sweep_algorithm_enabled(algorithm)) {
+                fprintf(stderr, "Error: unknown algorithm: %s\n\n", options.algorithms[i].c_str());
+                return 1;
+            }
+            algorithms.push_back(algorithm);
+        }
+    }
+
+    for (size_t i = 0; i < options.elem_sizes.size(); i++) {
+        std::size_t elem_size = options.elem_sizes[i].value;
+        if (elem_size != 1 && elem_size != 2 && elem_size != 4 && elem_size != 8 && elem_size != 16) {
+            fprintf(stderr, "Error: unsupported element size: %u\n\n", (uint32_t)elem_size);
+            return 1;
+        }
+    }
+
+    test::PerfCounterGroup * perf = nullptr;
+    if (options.perf) {
+        perf = new test::PerfCounterGroup();
+        if (!perf->is_valid()) {
+            fprintf(stderr, "Warning: perf events are not available, the counters are n/a.\n\n");
+        }
+    }
+
+    test::BenchReport report;
+    if (!report.open(options.output, options.format, options.roofline, options.perf)) {
+        delete perf;
+        fprintf(stderr, "Error: can't open the output file: %s\n\n", options.output.c_str());
+        return 1;
+    }
+    report.begin();
+
+    static const std::size_t kBufferAlignment = 64;
+
+    // The points faster than the speed of light of their size.
+    std::size_t above_roofline = 0;
+
+    for (size_t e = 0; e < options.elem_sizes.size(); e++) {
+        std::size_t elem_size = options.elem_sizes[e].value;
+        for (size_t l = 0; l < options.lengths.size(); l++) {
+            std::size_t length = options.lengths[l].value;
+            if (length < 2)
+                continue;
+
+            for (size_t a = 0; a < options.alignments.size(); a++) {
+                std::size_t align = options.alignments[a].value % kBufferAlignment;
+
+                std::size_t alloc_size = length * elem_size + kBufferAlignment * 2;
+                char * alloc_buffer = (char *)malloc(alloc_size);
+                if (alloc_buffer == nullptr) {
+                    fprintf(stderr, "Error: out of memory, length = %" PRIu64 ", elem_size = %u\n\n",
+                            (uint64_t)length, (uint32_t)elem_size);
+                    continue;
+                }
+                char * buffer = (char *)(((uintptr_t)alloc_buffer + kBufferAlignment - 1)
+                                         & ~(uintptr_t)(kBufferAlignment - 1)) + align;
+                for (std::size_t i = 0; i < length * elem_size; i++) {
+                    buffer[i] = (char)i;
+                }
+
+                test::RooflineBaseline baseline;
+                if (options.roofline) {
+                    if (test::measure_roofline(buffer, length * elem_size,
+                                               options.warmups, options.repeats,
+                                               bench_isolation, baseline)) {
+                        for (int kernel = 0; kernel < test::RooflineLast; kernel++) {
+                            test::BenchResult result;
+                            result.algorithm = test::kRooflineKernelNames[kernel];
+                            result.elem_size = elem_size;
+                            result.length = length;
+                            result.offset = 0;
+                            result.align = align;
+                            result.stats = baseline.stats[kernel];
+                            result.roofline = baseline.fraction(result.stats.median);
+                            report.add(result);
+                        }
+                    }
+                }
+
+                for (size_t o = 0; o < options.offsets.size(); o++) {
+                    // Skip the trivial rotations, some algorithms don't accept them.
+                    std::size_t offset = options.offsets[o].resolve(length);
+                    if (offset == 0 || offset >= length)
+                        continue;
+
+                    for (size_t n = 0; n < algorithms.size(); n++) {
+                        test::BenchResult result;
+                        result.algorithm = kSweepAlgorithmNames[algorithms[n]];
+                        result.elem_size = elem_size;
+                        result.length = length;
+                        result.offset = offset;
+                        result.align = align;
+                        if (run_sweep_elem_size(options, algorithms[n], elem_size,
+                                                buffer, length, offset, perf, result)) {
+                            result.roofline = baseline.fraction(result.stats.median);
+                            if (result.roofline > 1.0)
+                                above_roofline++;
+                            report.add(result);
+                        }
+                    }
+                }
+
+                free(alloc_buffer);
+            }
+        }
+    }
+
+    report.end();
+    delete perf;
+
+    if (above_roofline != 0) {
+        fprintf(stderr, "Warning: %u points are faster than the copy speed of light (SoL > 100%%),\n"
+                        "         check that the copy baseline is measured under the same conditions.\n\n",
+                (uint32_t)above_roofline);
+    }
+    return 0;
+}
+
 int main(int argn, char * argv[])
 {
+    test::BenchOptions options;
+    if (!test::parse_bench_options(argn, argv, options)) {
+        test::print_bench_usage(argv[0]);
+        return 1;
+    }
+    if (options.help) {
+        test::print_bench_usage(argv[0]);
+        return 0;
+    }
+
+    // Don't mix the settings into the results on stdout.
+    bench_isolation.setup(options.cpu, options.cache, options.settle,
+                          (options.sweep && options.output.empty()) ? stderr : stdout);
+    if (options.latency) {
+        rotate_latency_benchmark();
+        return 0;
+    }
+    if (options.divide) {
+        fast_div_batch_benchmark();
+        return 0;
+    }
+    if (options.sweep) {
+        return rotate_sweep(options);
+    }
+
     printf("\n");
     print_marcos();
 
 #if 1
+    rotate_calibrate();
     rotate_validate();
+    rotate_type_matrix_validate();
     rotate_benchmark();
+    rotate_type_matrix_benchmark();
+    rotate_offset_sweep();
+    rotate_branch_miss_benchmark();
 #endif
 
     return 0;
@@ -0,0 +1,149 @@
+
+#ifndef JSTD_TEST_ITEM_TYPES_H
+#define JSTD_TEST_ITEM_TYPES_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include <string>
+
+//
+// The element types of the validation and benchmark type matrix.
+//
+// item12 and item24 are not a power of 2 (the kValueSizeIsDivisible = false paths
+// of the SIMD kernels), std::string is not trivially copyable (the generic paths).
+//
+
+namespace test {
+
+struct item12 {
+    uint32_t a;
+    uint32_t b;
+    uint32_t c;
+};
+
+struct item16 {
+    uint64_t low;
+    uint64_t high;
+};
+
+struct item24 {
+    uint64_t a;
+    uint64_t b;
+    uint64_t c;
+};
+
+inline bool operator == (const item12 & lhs, const item12 & rhs) {
+    return (lhs.a == rhs.a && lhs.b == rhs.b && lhs.c == rhs.c);
+}
+
+inline bool operator != (const item12 & lhs, const item12 & rhs) {
+    return !(lhs == rhs);
+}
+
+inline bool operator == (const item16 & lhs, const item16 & rhs) {
+    return (lhs.low == rhs.low && lhs.high == rhs.high);
+}
+
+inline bool operator != (const item16 & lhs, const item16 & rhs) {
+    return !(lhs == rhs);
+}
+
+inline bool operator == (const item24 & lhs, const item24 & rhs) {
+    return (lhs.a == rhs.a && lhs.b == rhs.b && lhs.c == rhs.c);
+}
+
+inline bool operator != (const item24 & lhs, const item24 & rhs) {
+    return !(lhs == rhs);
+}
+
+//
+// item_traits<T>::make(i): the value of index i, the neighbours are always different.
+//
+template <typename T>
+struct item_traits {
+    static const char * name() { return "unknown"; }
+    static T make(std::size_t i) { return (T)i; }
+};
+
+template <>
+struct item_traits<uint8_t> {
+    static const char * name() { return "uint8_t"; }
+    static uint8_t make(std::size_t i) { return (uint8_t)i; }
+};
+
+template <>
+struct item_traits<uint16_t> {
+    static const char * name() { return "uint16_t"; }
+    static uint16_t make(std::size_t i) { return (uint16_t)i; }
+};
+
+template <>
+struct item_traits<int> {
+    static const char * name() { return "int"; }
+    static int make(std::size_t i) { return (int)i; }
+};
+
+template <>
+struct item_traits<uint64_t> {
+    static const char * name() { return "uint64_t"; }
+    static uint64_t make(std::size_t i) { return (uint64_t)i * 0x9E3779B97F4A7C15ull; }
+};
+
+template <>
+struct item_traits<item12> {
+    static const char * name() { return "item12"; }
+    static item12 make(std::size_t i) {
+        item12 item;
+        item.a = (uint32_t)i;
+        item.b = (uint32_t)(i >> 32) ^ 0x5A5A5A5Au;
+        item.c = ~(uint32_t)i;
+        return item;
+    }
+};
+
+template <>
+struct item_traits<item16> {
+    static const char * name() { return "item16"; }
+    static item16 make(std::size_t i) {
+        item16 item;
+        item.low = (uint64_t)i;
+        item.high = ~(uint64_t)i;
+        return item;
+    }
+};
+
+template <>
+struct item_traits<item24> {
+    static const char * name() { return "item24"; }
+    static item24 make(std::size_t i) {
+        item24 item;
+        item.a = (uint64_t)i;
+        item.b = (uint64_t)i * 0x9E3779B97F4A7C15ull;
+        item.c = ~(uint64_t)i;
+        return item;
+    }
+};
+
+template <>
+struct item_traits<std::string> {
+    static const char * name() { return "std::string"; }
+    static std::string make(std::size_t i) {
+        // Some strings are longer than the small string buffer, so they own heap memory.
+        char buf[64];
+        if ((i % 8) == 0)
+            snprintf(buf, sizeof(buf), "a long string (heap allocated) #%u", (uint32_t)i);
+        else
+            snprintf(buf, sizeof(buf), "#%u", (uint32_t)i);
+        return std::string(buf);
+    }
+};
+
+} // namespace test
+
+#endif // JSTD_TEST_ITEM_TYPES_H
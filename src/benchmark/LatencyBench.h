@@ -0,0 +1,113 @@
+
+#ifndef JSTD_TEST_LATENCY_BENCH_H
+#define JSTD_TEST_LATENCY_BENCH_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "StopWatch.h"
+
+#include "jstd/stddef.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#pragma intrinsic(_ReadWriteBarrier)
+#define LATENCY_COMPILER_BARRIER()  _ReadWriteBarrier()
+#else
+#define LATENCY_COMPILER_BARRIER()  __asm__ __volatile__ ("" : : : "memory")
+#endif
+
+//
+// Latency of the small rotations (ns/op).
+//
+// The buffer is small and hot in cache, a kernel rotates it back to back in a loop,
+// the iterations are doubled until a loop takes kLatencyMinMillisecs at least,
+// then the best of kLatencyRepeats loops is kept. The loop overhead (an indirect
+// call of an empty kernel) is measured the same way and subtracted.
+//
+// The loops are timed with the TSC (test::rdtscStopWatch) where it's available.
+//
+
+namespace test {
+
+static const double kLatencyMinMillisecs = 5.0;
+static const int    kLatencyRepeats = 5;
+
+template <typename T>
+struct LatencyKernel {
+    typedef void (*type)(T * first, T * mid, T * last);
+};
+
+template <typename T>
+JSTD_NO_INLINE
+void latency_empty_kernel(T * first, T * mid, T * last)
+{
+    (void)first;
+    (void)mid;
+    (void)last;
+    LATENCY_COMPILER_BARRIER();
+}
+
+template <typename T>
+JSTD_NO_INLINE
+double latency_loop(typename LatencyKernel<T>::type kernel,
+                    T * first, T * mid, T * last, std::size_t iterations)
+{
+    test::rdtscStopWatch sw;
+    sw.start();
+    for (std::size_t i = 0; i < iterations; i++) {
+        kernel(first, mid, last);
+    }
+    sw.stop();
+    return sw.getElapsedMillisec();
+}
+
+//
+// Returns the best ns/op of the kernel, the loop overhead is not subtracted.
+//
+template <typename T>
+double measure_latency_raw(typename LatencyKernel<T>::type kernel, T * first, T * mid, T * last)
+{
+    // Find the iterations, it also warms up the buffer and the branch predictors.
+    std::size_t iterations = 16;
+    double elapsed = latency_loop(kernel, first, mid, last, iterations);
+    while (elapsed < kLatencyMinMillisecs && iterations < (std::size_t(1) << 40)) {
+        iterations *= 2;
+        elapsed = latency_loop(kernel, first, mid, last, iterations);
+    }
+
+    double best_time = elapsed;
+    for (int repeat = 1; repeat < kLatencyRepeats; repeat++) {
+        elapsed = latency_loop(kernel, first, mid, last, iterations);
+        if (elapsed < best_time)
+            best_time = elapsed;
+    }
+    return (best_time * 1000000.0 / (double)iterations);
+}
+
+template <typename T>
+double measure_latency_overhead(T * first, T * mid, T * last)
+{
+    return measure_latency_raw<T>(&latency_empty_kernel<T>, first, mid, last);
+}
+
+//
+// Returns the ns/op of the kernel, minus the loop overhead (not less than 0).
+//
+template <typename T>
+double measure_latency(typename LatencyKernel<T>::type kernel,
+                       T * first, T * mid, T * last, double overhead)
+{
+    double latency = measure_latency_raw<T>(kernel, first, mid, last) - overhead;
+    return ((latency > 0.0) ? latency : 0.0);
+}
+
+} // namespace test
+
+#undef LATENCY_COMPILER_BARRIER
+
+#endif // JSTD_TEST_LATENCY_BENCH_H
@@ -0,0 +1,350 @@
+
+#ifndef JSTD_TEST_PERF_COUNTER_H
+#define JSTD_TEST_PERF_COUNTER_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#define JSTD_HAVE_PERF_EVENT    1
+#else
+#define JSTD_HAVE_PERF_EVENT    0
+#endif
+
+//
+// Hardware performance counter (user space only), via perf_event_open(2).
+//
+// If the counter can't be opened (not Linux, in a container or VM without PMU,
+// or perf_event_paranoid is too high), is_valid() returns false and value() is 0,
+// the benchmark still runs, just prints "n/a".
+//
+// See: https://man7.org/linux/man-pages/man2/perf_event_open.2.html
+//
+
+namespace test {
+
+class PerfCounter {
+public:
+    enum EventType {
+        BranchMisses,
+        BranchInstructions,
+        CacheMisses,
+        Instructions,
+        CpuCycles
+    };
+
+private:
+    int         fd_;
+    uint64_t    value_;
+
+public:
+    explicit PerfCounter(EventType event = BranchMisses) : fd_(-1), value_(0) {
+        this->open(event);
+    }
+
+    ~PerfCounter() {
+        this->close();
+    }
+
+    bool is_valid() const { return (this->fd_ >= 0); }
+
+    uint64_t value() const { return this->value_; }
+
+    void start() {
+        this->value_ = 0;
+#if JSTD_HAVE_PERF_EVENT
+        if (this->is_valid()) {
+            ::ioctl(this->fd_, PERF_EVENT_IOC_RESET, 0);
+            ::ioctl(this->fd_, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    void stop() {
+#if JSTD_HAVE_PERF_EVENT
+        if (this->is_valid()) {
+            ::ioctl(this->fd_, PERF_EVENT_IOC_DISABLE, 0);
+            uint64_t count = 0;
+            if (::read(this->fd_, &count, sizeof(count)) == (ssize_t)sizeof(count))
+                this->value_ = count;
+        }
+#endif
+    }
+
+private:
+#if JSTD_HAVE_PERF_EVENT
+    static uint64_t event_config(EventType event) {
+        switch (event) {
+            case BranchMisses:
+                return PERF_COUNT_HW_BRANCH_MISSES;
+            case BranchInstructions:
+                return PERF_COUNT_HW_BRANCH_INSTRUCTIONS;
+            case CacheMisses:
+                return PERF_COUNT_HW_CACHE_MISSES;
+            case Instructions:
+                return PERF_COUNT_HW_INSTRUCTIONS;
+            case CpuCycles:
+            default:
+                return PERF_COUNT_HW_CPU_CYCLES;
+        }
+    }
+
+    void open(EventType event) {
+        struct perf_event_attr attr;
+        ::memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = event_config(event);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        // Measure the calling thread on any cpu.
+        this->fd_ = (int)::syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+
+    void close() {
+        if (this->fd_ >= 0) {
+            ::close(this->fd_);
+            this->fd_ = -1;
+        }
+    }
+#else
+    void open(EventType event) {
+        (void)event;
+        this->fd_ = -1;
+    }
+
+    void close() {
+        this->fd_ = -1;
+    }
+#endif // JSTD_HAVE_PERF_EVENT
+
+    PerfCounter(const PerfCounter & src) = delete;
+    PerfCounter & operator = (const PerfCounter & rhs) = delete;
+};
+
+//
+// A group of hardware counters, scheduled on the PMU together, so the ratios
+// (IPC, misses per KB) are taken over exactly the same interval.
+//
+// The events that can't be opened (e.g. no dTLB event on this CPU) are skipped
+// one by one, is_available(event) tells which ones are counting. If the kernel
+// multiplexes the group, the values are scaled by time_enabled / time_running.
+//
+// There is no portable event of the store-forwarding stalls, it needs the raw
+// event code of each micro-architecture, so it's not in the group.
+//
+class PerfCounterGroup {
+public:
+    enum Event {
+        Cycles,
+        Instructions,
+        L1DMisses,
+        LLCMisses,
+        DTLBMisses,
+        BranchMisses,
+        EventLast
+    };
+
+private:
+    int         leader_fd_;
+    int         fds_[EventLast];
+    uint64_t    ids_[EventLast];
+    uint64_t    values_[EventLast];
+    bool        scheduled_;
+
+public:
+    PerfCounterGroup() : leader_fd_(-1), scheduled_(false) {
+        for (int event = 0; event < EventLast; event++) {
+            this->fds_[event] = -1;
+            this->ids_[event] = 0;
+            this->values_[event] = 0;
+        }
+        this->open();
+    }
+
+    ~PerfCounterGroup() {
+        this->close();
+    }
+
+    // At least one counter is opened.
+    bool is_valid() const { return (this->leader_fd_ >= 0); }
+
+    bool is_available(Event event) const { return (this->fds_[event] >= 0); }
+
+    // The last interval was counted (the group was scheduled on the PMU).
+    bool is_counted() const { return this->scheduled_; }
+
+    uint64_t value(Event event) const { return this->values_[event]; }
+
+    static const char * event_name(Event event) {
+        static const char * const kEventNames[EventLast] = {
+            "cycles",
+            "instructions",
+            "L1D misses",
+            "LLC misses",
+            "dTLB misses",
+            "branch-misses"
+        };
+        return ((event >= 0 && event < EventLast) ? kEventNames[event] : "unknown");
+    }
+
+    void start() {
+        for (int event = 0; event < EventLast; event++) {
+            this->values_[event] = 0;
+        }
+        this->scheduled_ = false;
+#if JSTD_HAVE_PERF_EVENT
+        if (this->is_valid()) {
+            ::ioctl(this->leader_fd_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ::ioctl(this->leader_fd_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+#endif
+    }
+
+    void stop() {
+#if JSTD_HAVE_PERF_EVENT
+        if (this->is_valid()) {
+            ::ioctl(this->leader_fd_, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+            // PERF_FORMAT_GROUP | PERF_FORMAT_ID | PERF_FORMAT_TOTAL_TIME_ENABLED | RUNNING:
+            // { nr, time_enabled, time_running, { value, id } [nr] }
+            uint64_t buffer[3 + EventLast * 2];
+            ssize_t read_bytes = ::read(this->leader_fd_, buffer, sizeof(buffer));
+            if (read_bytes < (ssize_t)(sizeof(uint64_t) * 3))
+                return;
+
+            uint64_t nr = buffer[0];
+            uint64_t time_enabled = buffer[1];
+            uint64_t time_running = buffer[2];
+            if (time_running == 0 || nr > EventLast)
+                return;
+
+            double scale = (time_running < time_enabled) ?
+                           ((double)time_enabled / (double)time_running) : 1.0;
+            for (uint64_t i = 0; i < nr; i++) {
+                uint64_t count = buffer[3 + i * 2 + 0];
+                uint64_t id    = buffer[3 + i * 2 + 1];
+                for (int event = 0; event < EventLast; event++) {
+                    if (this->fds_[event] >= 0 && this->ids_[event] == id) {
+                        this->values_[event] = (uint64_t)((double)count * scale);
+                        break;
+                    }
+                }
+            }
+            this->scheduled_ = true;
+        }
+#endif
+    }
+
+private:
+#if JSTD_HAVE_PERF_EVENT
+    static uint64_t hw_cache_config(uint64_t cache, uint64_t op, uint64_t result) {
+        return (cache | (op << 8) | (result << 16));
+    }
+
+    static void event_config(Event event, __u32 & type, __u64 & config) {
+        switch (event) {
+            case Cycles:
+                type = PERF_TYPE_HARDWARE;
+                config = PERF_COUNT_HW_CPU_CYCLES;
+                break;
+            case Instructions:
+                type = PERF_TYPE_HARDWARE;
+                config = PERF_COUNT_HW_INSTRUCTIONS;
+                break;
+            case L1DMisses:
+                type = PERF_TYPE_HW_CACHE;
+                config = hw_cache_config(PERF_COUNT_HW_CACHE_L1D,
+                                         PERF_COUNT_HW_CACHE_OP_READ,
+                                         PERF_COUNT_HW_CACHE_RESULT_MISS);
+                break;
+            case LLCMisses:
+                type = PERF_TYPE_HW_CACHE;
+                config = hw_cache_config(PERF_COUNT_HW_CACHE_LL,
+                                         PERF_COUNT_HW_CACHE_OP_READ,
+                                         PERF_COUNT_HW_CACHE_RESULT_MISS);
+                break;
+            case DTLBMisses:
+                type = PERF_TYPE_HW_CACHE;
+                config = hw_cache_config(PERF_COUNT_HW_CACHE_DTLB,
+                                         PERF_COUNT_HW_CACHE_OP_READ,
+                                         PERF_COUNT_HW_CACHE_RESULT_MISS);
+                break;
+            case BranchMisses:
+            default:
+                type = PERF_TYPE_HARDWARE;
+                config = PERF_COUNT_HW_BRANCH_MISSES;
+                break;
+        }
+    }
+
+    void open() {
+        for (int event = 0; event < EventLast; event++) {
+            struct perf_event_attr attr;
+            ::memset(&attr, 0, sizeof(attr));
+            event_config((Event)event, attr.type, attr.config);
+            attr.size = sizeof(attr);
+            attr.disabled = (this->leader_fd_ < 0) ? 1 : 0;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID |
+                               PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            // The first opened event is the group leader.
+            int fd = (int)::syscall(__NR_perf_event_open, &attr, 0, -1, this->leader_fd_, 0);
+            if (fd < 0)
+                continue;
+
+            uint64_t id = 0;
+            if (::ioctl(fd, PERF_EVENT_IOC_ID, &id) != 0) {
+                ::close(fd);
+                continue;
+            }
+
+            this->fds_[event] = fd;
+            this->ids_[event] = id;
+            if (this->leader_fd_ < 0)
+                this->leader_fd_ = fd;
+        }
+    }
+
+    void close() {
+        // Close the members first, then the leader.
+        for (int event = EventLast - 1; event >= 0; event--) {
+            if (this->fds_[event] >= 0 && this->fds_[event] != this->leader_fd_) {
+                ::close(this->fds_[event]);
+            }
+            this->fds_[event] = -1;
+        }
+        if (this->leader_fd_ >= 0) {
+            ::close(this->leader_fd_);
+            this->leader_fd_ = -1;
+        }
+    }
+#else
+    void open() {
+        this->leader_fd_ = -1;
+    }
+
+    void close() {
+        this->leader_fd_ = -1;
+    }
+#endif // JSTD_HAVE_PERF_EVENT
+
+    PerfCounterGroup(const PerfCounterGroup & src) = delete;
+    PerfCounterGroup & operator = (const PerfCounterGroup & rhs) = delete;
+};
+
+} // namespace test
+
+#endif // JSTD_TEST_PERF_COUNTER_H
@@ -0,0 +1,142 @@
+
+#ifndef JSTD_TEST_ROOFLINE_H
+#define JSTD_TEST_ROOFLINE_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include "StopWatch.h"
+#include "BenchReport.h"
+#include "BenchIsolation.h"
+
+#include "jstd/ArrayRotate_SIMD.h"
+
+//
+// The bandwidth roofline of a rotation.
+//
+// A rotation reads and writes each byte once at least, so it can't be faster
+// than a copy of the same bytes. Each size is measured with memcpy() and the AVX
+// copy kernel (to another buffer, its ranges are JSTD_RESTRICT), and memmove() (in
+// place, shift 256 bytes, so the footprint is the same as the rotation), and the
+// fastest median of them is the speed of light (SoL) of the size.
+//
+// roofline = SoL time / rotate time, 1.0 means the rotation runs at the copy speed.
+//
+
+namespace test {
+
+enum RooflineKernel {
+    RooflineMemcpy,
+    RooflineMemmove,
+    RooflineAvxMemCopy,
+    RooflineLast
+};
+
+static const char * const kRooflineKernelNames[RooflineLast] = {
+    "memcpy",
+    "memmove",
+    "jstd::simd::avx_mem_copy_N"
+};
+
+struct RooflineBaseline {
+    BenchStats  stats[RooflineLast];
+
+    // The fastest median time of the copy kernels (unit: ms).
+    double ceiling() const {
+        double best_time = -1.0;
+        for (int kernel = 0; kernel < RooflineLast; kernel++) {
+            if (this->stats[kernel].count == 0)
+                continue;
+            if (best_time < 0.0 || this->stats[kernel].median < best_time)
+                best_time = this->stats[kernel].median;
+        }
+        return best_time;
+    }
+
+    // Fraction of the speed of light, < 0 if not available.
+    double fraction(double elapsed) const {
+        double best_time = this->ceiling();
+        if (best_time <= 0.0 || elapsed <= 0.0)
+            return -1.0;
+        return (best_time / elapsed);
+    }
+};
+
+static void run_roofline_kernel(int kernel, char * buffer, char * copy_buffer, std::size_t bytes)
+{
+    // The shift of the in place memmove().
+    static const std::size_t kMoveShift = 256;
+
+    switch (kernel) {
+        case RooflineMemcpy:
+            ::memcpy(copy_buffer, buffer, bytes);
+            break;
+        case RooflineMemmove:
+            if (bytes > kMoveShift)
+                ::memmove(buffer, buffer + kMoveShift, bytes - kMoveShift);
+            break;
+        case RooflineAvxMemCopy:
+            jstd::simd::avx_mem_copy_N_store_aligned<char, 8, false, false>(
+                copy_buffer, buffer, buffer + bytes);
+            break;
+        default:
+            break;
+    }
+}
+
+//
+// Measure the copy kernels of [buffer, buffer + bytes), the content of buffer is changed.
+// The buffer and the copy buffer are prepared by isolation before each timed run,
+// the same cache state and frequency settling as the rotations they are compared to.
+//
+static bool measure_roofline(char * buffer, std::size_t bytes,
+                             std::size_t warmups, std::size_t repeats,
+                             BenchIsolation & isolation, RooflineBaseline & baseline)
+{
+    static const std::size_t kAlignment = 64;
+
+    // The copy buffer of memcpy() and the AVX copy kernel is aligned to 64 bytes,
+    // the same as the buffer.
+    char * alloc_buffer = (char *)::malloc(bytes + kAlignment);
+    if (alloc_buffer == nullptr)
+        return false;
+    char * copy_buffer = (char *)(((uintptr_t)alloc_buffer + kAlignment - 1)
+                                  & ~(uintptr_t)(kAlignment - 1));
+    ::memset(copy_buffer, 0, bytes);
+
+    test::StopWatch sw;
+    std::vector<double> samples;
+    samples.reserve(repeats);
+
+    for (int kernel = 0; kernel < RooflineLast; kernel++) {
+        for (std::size_t i = 0; i < warmups; i++) {
+            run_roofline_kernel(kernel, buffer, copy_buffer, bytes);
+        }
+
+        samples.clear();
+        for (std::size_t i = 0; i < repeats; i++) {
+            isolation.prepare(copy_buffer, bytes);
+            isolation.prepare(buffer, bytes);
+            sw.start();
+            run_roofline_kernel(kernel, buffer, copy_buffer, bytes);
+            sw.stop();
+            samples.push_back(sw.getElapsedMillisec());
+        }
+        baseline.stats[kernel] = compute_bench_stats(samples);
+    }
+
+    ::free(alloc_buffer);
+    return true;
+}
+
+} // namespace test
+
+#endif // JSTD_TEST_ROOFLINE_H
@@ -30,6 +30,26 @@
 #include <chrono>
 #endif
 
+#include <stdint.h>
+#include <utility>          // For std::swap()
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__amd64__) || defined(__x86_64__) \
+ || defined(_M_IX86) || defined(__i386__)
+#define HAVE_RDTSC_STOPWATCH    1
+#else
+#define HAVE_RDTSC_STOPWATCH    0
+#endif
+
+#if HAVE_RDTSC_STOPWATCH
+#if defined(_MSC_VER)
+#include <intrin.h>         // For __rdtsc(), __rdtscp(), __cpuid()
+#else
+#include <x86intrin.h>      // For __rdtsc(), __rdtscp()
+#include <cpuid.h>          // For __get_cpuid()
+#endif
+#include <emmintrin.h>      // For _mm_lfence()
+#endif // HAVE_RDTSC_STOPWATCH
+
 #ifndef __COMPILER_BARRIER
 #if defined(_MSC_VER) || defined(_WIN32) || defined(WIN32) || defined(OS_WINDOWS) || defined(_WINDOWS_)
 #include <intrin.h>
@@ -202,6 +222,11 @@ public:
         return elapsed_time;
     }
 
+    // The raw ticks of the impl_type, e.g. the TSC cycles of rdtscStopWatchImpl.
+    time_stamp_t getElapsedTicks() const {
+        return impl_type::interval(stop_time_, start_time_);
+    }
+
     time_float_t getElapsedNanosec() {
         return (this->getElapsedSecond() * time_ratio::nanosecs);
     }
@@ -357,7 +382,7 @@ public:
 
     time_float_t getDurationTime() const {
         detail::duration_time<time_float_t> _duration_time = impl_type::duration_time(stop_time_, start_time_);
-        return _duration_time;
+        return _duration_time.seconds();
     }
 
     time_float_t getDurationMicrosec() {
@@ -576,6 +601,181 @@ typedef StopWatchExBase< defaultStopWatchImpl<double> >     defaultStopWatchEx;
 
 #endif // HAVE_STD_CHRONO_H
 
+#if HAVE_RDTSC_STOPWATCH
+
+//
+// Time Stamp Counter, for the rotations of 10 -- 50 ns.
+//
+// now() is "rdtscp; lfence": rdtscp waits until all the previous instructions
+// have executed, lfence keeps the later instructions from starting before it,
+// so the timed code can't leak out of [start(), stop()]. Without rdtscp, it's
+// "lfence; rdtsc; lfence".
+//
+// The ticks are the TSC cycles (the reference cycles, not the core cycles),
+// the TSC frequency is calibrated once against CLOCK_MONOTONIC_RAW (Linux),
+// QueryPerformanceCounter (Windows) or std::chrono::steady_clock.
+// If the TSC is not invariant (constant rate and doesn't stop in the C-states,
+// CPUID.80000007H:EDX[8]), the time is not reliable, see is_invariant().
+//
+template <typename TimeFloatTy>
+class rdtscStopWatchImpl {
+public:
+    typedef TimeFloatTy                                     time_float_t;
+    typedef std::uint64_t                                   time_stamp_t;
+    typedef std::uint64_t                                   time_point_t;
+    typedef time_float_t                                    duration_type;
+    typedef rdtscStopWatchImpl<TimeFloatTy>                 this_type;
+
+    struct tsc_info {
+        bool    has_rdtscp;
+        bool    is_invariant;
+        double  frequency;      // unit: Hz
+    };
+
+public:
+    rdtscStopWatchImpl() {}
+    ~rdtscStopWatchImpl() {}
+
+    static time_stamp_t interval(time_point_t now_time, time_point_t old_time) {
+        return static_cast<time_stamp_t>(now_time - old_time);
+    }
+
+    static time_point_t now() {
+        static const bool has_rdtscp = this_type::info().has_rdtscp;
+        time_point_t now_time;
+        if (has_rdtscp) {
+            unsigned int aux;
+            now_time = __rdtscp(&aux);
+            _mm_lfence();
+        } else {
+            _mm_lfence();
+            now_time = __rdtsc();
+            _mm_lfence();
+        }
+        return now_time;
+    }
+
+    static time_float_t duration_time(time_point_t now_time, time_point_t old_time) {
+        return (static_cast<time_float_t>(this_type::interval(now_time, old_time)) /
+                static_cast<time_float_t>(this_type::info().frequency));
+    }
+
+    static time_stamp_t timestamp(time_point_t now_time, time_point_t base_time) {
+        return this_type::interval(now_time, base_time);
+    }
+
+    static time_float_t cycles_to_nanosecs(time_stamp_t cycles) {
+        return (static_cast<time_float_t>(cycles) * TimeRatio<time_float_t>::nanosecs /
+                static_cast<time_float_t>(this_type::info().frequency));
+    }
+
+    static bool is_invariant() {
+        return this_type::info().is_invariant;
+    }
+
+    // The TSC frequency (unit: Hz).
+    static double frequency() {
+        return this_type::info().frequency;
+    }
+
+    static const tsc_info & info() {
+        static const tsc_info s_info = this_type::detect();
+        return s_info;
+    }
+
+private:
+    static void cpuid(unsigned int leaf, unsigned int regs[4]) {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, (int)leaf);
+        for (int i = 0; i < 4; i++) {
+            regs[i] = (unsigned int)info[i];
+        }
+#else
+        if (__get_cpuid(leaf, &regs[0], &regs[1], &regs[2], &regs[3]) == 0) {
+            regs[0] = regs[1] = regs[2] = regs[3] = 0;
+        }
+#endif
+    }
+
+    // A monotonic clock that is not adjusted by NTP (unit: ns).
+    static double monotonic_nanosecs() {
+#if defined(_WIN32) || defined(WIN32) || defined(OS_WINDOWS) || defined(_WINDOWS_)
+        LARGE_INTEGER counter, frequency;
+        ::QueryPerformanceCounter(&counter);
+        ::QueryPerformanceFrequency(&frequency);
+        return ((double)counter.QuadPart * 1.0E9 / (double)frequency.QuadPart);
+#elif defined(CLOCK_MONOTONIC_RAW)
+        struct timespec ts;
+        ::clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+        return ((double)ts.tv_sec * 1.0E9 + (double)ts.tv_nsec);
+#elif HAVE_STD_CHRONO_H
+        return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+#else
+        struct timeval tv;
+        ::gettimeofday(&tv, nullptr);
+        return ((double)tv.tv_sec * 1.0E9 + (double)tv.tv_usec * 1.0E3);
+#endif
+    }
+
+    static tsc_info detect() {
+        tsc_info info;
+        unsigned int regs[4];
+
+        this_type::cpuid(0x80000000u, regs);
+        unsigned int max_ext_leaf = regs[0];
+        info.has_rdtscp = false;
+        info.is_invariant = false;
+        if (max_ext_leaf >= 0x80000001u) {
+            this_type::cpuid(0x80000001u, regs);
+            info.has_rdtscp = ((regs[3] & (1u << 27)) != 0);
+        }
+        if (max_ext_leaf >= 0x80000007u) {
+            this_type::cpuid(0x80000007u, regs);
+            info.is_invariant = ((regs[3] & (1u << 8)) != 0);
+        }
+        info.frequency = this_type::calibrate();
+        return info;
+    }
+
+    //
+    // The median of 3 rounds, each round counts the TSC cycles of about 10 ms.
+    //
+    static double calibrate() {
+        static const double kRoundNanosecs = 10.0 * 1.0E6;
+
+        double rounds[3];
+        for (int round = 0; round < 3; round++) {
+            _mm_lfence();
+            double start_ns = this_type::monotonic_nanosecs();
+            time_point_t start_tsc = __rdtsc();
+            double stop_ns;
+            do {
+                stop_ns = this_type::monotonic_nanosecs();
+            } while ((stop_ns - start_ns) < kRoundNanosecs);
+            time_point_t stop_tsc = __rdtsc();
+            _mm_lfence();
+            rounds[round] = (double)(stop_tsc - start_tsc) * 1.0E9 / (stop_ns - start_ns);
+        }
+
+        if (rounds[0] > rounds[1]) std::swap(rounds[0], rounds[1]);
+        if (rounds[1] > rounds[2]) std::swap(rounds[1], rounds[2]);
+        if (rounds[0] > rounds[1]) std::swap(rounds[0], rounds[1]);
+        return rounds[1];
+    }
+};
+
+typedef StopWatchBase< rdtscStopWatchImpl<double> >         rdtscStopWatch;
+typedef StopWatchExBase< rdtscStopWatchImpl<double> >       rdtscStopWatchEx;
+
+#else
+
+typedef defaultStopWatch                                    rdtscStopWatch;
+typedef defaultStopWatchEx                                  rdtscStopWatchEx;
+
+#endif // HAVE_RDTSC_STOPWATCH
+
 #if defined(_WIN32) || defined(WIN32) || defined(OS_WINDOWS) || defined(_WINDOWS_)
 
 template <typename TimeFloatTy>
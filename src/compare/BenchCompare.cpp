@@ -0,0 +1,434 @@
+
+#if defined(_MSC_VER)
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <math.h>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+
+//
+// Benchmark regression gate.
+//
+// Compares the results of two runs of the benchmark parameter sweep
+// (benchmark --sweep --format=json|csv --output=FILE), point by point,
+// the points are matched by (algorithm, elem_size, length, offset, align).
+//
+// ratio = current median / baseline median, > 1.0 is slower.
+//
+// The noise of a point is half of its relative spread, (p90 - min) / median / 2,
+// and the threshold of a point is:
+//
+//   threshold = max(--threshold, --noise-factor * sqrt(noise_base^2 + noise_cur^2))
+//
+// so a noisy point needs a bigger change to be reported.
+//
+// Usage:
+//
+//   bench_compare baseline.json current.json [--threshold=0.05] [--noise-factor=2]
+//                 [--all] [--ignore-missing]
+//
+// Exit code: 0 no regression, 1 regressions (or missing points), 2 bad input.
+//
+
+static const int kExitOk = 0;
+static const int kExitRegression = 1;
+static const int kExitBadInput = 2;
+
+struct ComparePoint {
+    std::string     algorithm;
+    uint64_t        elem_size;
+    uint64_t        length;
+    uint64_t        offset;
+    uint64_t        align;
+    uint64_t        reps;
+    double          min;
+    double          median;
+    double          p90;
+
+    ComparePoint() : elem_size(0), length(0), offset(0), align(0), reps(0),
+                     min(0.0), median(0.0), p90(0.0) {}
+
+    std::string key() const {
+        char buf[128];
+        snprintf(buf, sizeof(buf), "|%" PRIu64 "|%" PRIu64 "|%" PRIu64 "|%" PRIu64,
+                 this->elem_size, this->length, this->offset, this->align);
+        return (this->algorithm + buf);
+    }
+
+    // Half of the relative spread of the repetitions.
+    double noise() const {
+        if (this->median <= 0.0 || this->p90 < this->min)
+            return 0.0;
+        return ((this->p90 - this->min) / this->median * 0.5);
+    }
+};
+
+struct CompareOptions {
+    std::string     baseline;
+    std::string     current;
+    double          threshold;
+    double          noise_factor;
+    bool            show_all;
+    bool            ignore_missing;
+
+    CompareOptions() : threshold(0.05), noise_factor(2.0), show_all(false), ignore_missing(false) {}
+};
+
+//
+// Set a field of the point by its name (the JSON key or the CSV column).
+//
+static void set_point_field(ComparePoint & point, const std::string & name, const std::string & value)
+{
+    if (name == "algorithm")
+        point.algorithm = value;
+    else if (name == "elem_size")
+        point.elem_size = ::strtoull(value.c_str(), nullptr, 10);
+    else if (name == "length")
+        point.length = ::strtoull(value.c_str(), nullptr, 10);
+    else if (name == "offset")
+        point.offset = ::strtoull(value.c_str(), nullptr, 10);
+    else if (name == "align")
+        point.align = ::strtoull(value.c_str(), nullptr, 10);
+    else if (name == "reps")
+        point.reps = ::strtoull(value.c_str(), nullptr, 10);
+    else if (name == "min_ms")
+        point.min = ::strtod(value.c_str(), nullptr);
+    else if (name == "median_ms")
+        point.median = ::strtod(value.c_str(), nullptr);
+    else if (name == "p90_ms")
+        point.p90 = ::strtod(value.c_str(), nullptr);
+}
+
+static bool read_file(const char * filename, std::string & text)
+{
+    FILE * fp = fopen(filename, "rb");
+    if (fp == nullptr)
+        return false;
+    char buf[4096];
+    std::size_t size;
+    text.clear();
+    while ((size = fread(buf, 1, sizeof(buf), fp)) > 0) {
+        text.append(buf, size);
+    }
+    fclose(fp);
+    return true;
+}
+
+static void skip_spaces(const std::string & text, std::size_t & pos)
+{
+    while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' ||
+                                 text[pos] == '\r' || text[pos] == '\n')) {
+        pos++;
+    }
+}
+
+static bool parse_json_string(const std::string & text, std::size_t & pos, std::string & value)
+{
+    if (pos >= text.size() || text[pos] != '"')
+        return false;
+    pos++;
+    value.clear();
+    while (pos < text.size() && text[pos] != '"') {
+        if (text[pos] == '\\' && pos + 1 < text.size())
+            pos++;
+        value.push_back(text[pos]);
+        pos++;
+    }
+    if (pos >= text.size())
+        return false;
+    pos++;
+    return true;
+}
+
+//
+// Parse a flat object { "key": value, ... }, the values are strings, numbers or null.
+//
+static bool parse_json_point(const std::string & text, std::size_t & pos, ComparePoint & point)
+{
+    if (pos >= text.size() || text[pos] != '{')
+        return false;
+    pos++;
+    for (;;) {
+        skip_spaces(text, pos);
+        if (pos < text.size() && text[pos] == '}') {
+            pos++;
+            return true;
+        }
+        std::string name, value;
+        if (!parse_json_string(text, pos, name))
+            return false;
+        skip_spaces(text, pos);
+        if (pos >= text.size() || text[pos] != ':')
+            return false;
+        pos++;
+        skip_spaces(text, pos);
+        if (pos < text.size() && text[pos] == '"') {
+            if (!parse_json_string(text, pos, value))
+                return false;
+        } else {
+            std::size_t first = pos;
+            while (pos < text.size() && text[pos] != ',' && text[pos] != '}' &&
+                   text[pos] != ' ' && text[pos] != '\r' && text[pos] != '\n') {
+                pos++;
+            }
+            value = text.substr(first, pos - first);
+        }
+        set_point_field(point, name, value);
+        skip_spaces(text, pos);
+        if (pos < text.size() && text[pos] == ',')
+            pos++;
+    }
+}
+
+static bool parse_json_results(const std::string & text, std::vector<ComparePoint> & points)
+{
+    std::size_t pos = text.find("\"results\"");
+    if (pos == std::string::npos)
+        return false;
+    pos = text.find('[', pos);
+    if (pos == std::string::npos)
+        return false;
+    pos++;
+    for (;;) {
+        skip_spaces(text, pos);
+        if (pos >= text.size())
+            return false;
+        if (text[pos] == ']')
+            return true;
+        ComparePoint point;
+        if (!parse_json_point(text, pos, point))
+            return false;
+        points.push_back(point);
+        skip_spaces(text, pos);
+        if (pos < text.size() && text[pos] == ',')
+            pos++;
+    }
+}
+
+static void split_csv_line(const std::string & line, std::vector<std::string> & fields)
+{
+    fields.clear();
+    std::size_t first = 0;
+    for (;;) {
+        std::size_t comma = line.find(',', first);
+        if (comma == std::string::npos) {
+            fields.push_back(line.substr(first));
+            break;
+        }
+        fields.push_back(line.substr(first, comma - first));
+        first = comma + 1;
+    }
+}
+
+static bool parse_csv_results(const std::string & text, std::vector<ComparePoint> & points)
+{
+    std::vector<std::string> columns, fields;
+    std::size_t first = 0;
+    bool has_header = false;
+    while (first < text.size()) {
+        std::size_t eol = text.find('\n', first);
+        if (eol == std::string::npos)
+            eol = text.size();
+        std::string line = text.substr(first, eol - first);
+        if (!line.empty() && line[line.size() - 1] == '\r')
+            line.resize(line.size() - 1);
+        first = eol + 1;
+        if (line.empty())
+            continue;
+
+        if (!has_header) {
+            split_csv_line(line, columns);
+            has_header = true;
+            continue;
+        }
+        split_csv_line(line, fields);
+        ComparePoint point;
+        for (std::size_t i = 0; i < fields.size() && i < columns.size(); i++) {
+            set_point_field(point, columns[i], fields[i]);
+        }
+        points.push_back(point);
+    }
+    return has_header;
+}
+
+static bool load_results(const char * filename, std::vector<ComparePoint> & points)
+{
+    std::string text;
+    if (!read_file(filename, text)) {
+        fprintf(stderr, "Error: can't read the file: %s\n\n", filename);
+        return false;
+    }
+
+    std::size_t pos = 0;
+    skip_spaces(text, pos);
+    bool ok;
+    if (pos < text.size() && text[pos] == '{')
+        ok = parse_json_results(text, points);
+    else
+        ok = parse_csv_results(text, points);
+
+    if (!ok) {
+        fprintf(stderr, "Error: not a benchmark JSON or CSV result: %s\n\n", filename);
+        return false;
+    }
+    for (std::size_t i = 0; i < points.size(); i++) {
+        if (points[i].algorithm.empty() || points[i].median <= 0.0) {
+            fprintf(stderr, "Error: bad result #%u (no algorithm or median_ms): %s\n\n",
+                    (uint32_t)i, filename);
+            return false;
+        }
+    }
+    return true;
+}
+
+static void print_usage(const char * program)
+{
+    printf("Usage: %s baseline.json current.json [options]\n\n", program);
+    printf("  Compare two results of \"benchmark --sweep --format=json|csv\", point by point.\n\n");
+    printf("  --threshold=X        The minimum relative change to report, default: 0.05 (5%%).\n");
+    printf("  --noise-factor=X     The threshold is X times the noise of the point at least, default: 2.\n");
+    printf("  --all                Print all points, not only the changed ones.\n");
+    printf("  --ignore-missing     A baseline point that isn't in the current result is not an error.\n");
+    printf("  --help               Show this help.\n\n");
+    printf("  Exit code: 0 no regression, 1 regressions (or missing points), 2 bad input.\n\n");
+}
+
+static bool parse_options(int argc, char * argv[], CompareOptions & options)
+{
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; i++) {
+        const char * arg = argv[i];
+        const char * value = ::strchr(arg, '=');
+        std::string name = (value != nullptr) ? std::string(arg, value - arg) : std::string(arg);
+        if (value != nullptr)
+            value++;
+
+        bool ok = true;
+        if (arg[0] != '-') {
+            files.push_back(arg);
+        } else if (name == "--help" || name == "-h") {
+            return false;
+        } else if (name == "--all") {
+            options.show_all = true;
+        } else if (name == "--ignore-missing") {
+            options.ignore_missing = true;
+        } else if (value == nullptr) {
+            ok = false;
+        } else if (name == "--threshold") {
+            options.threshold = ::strtod(value, nullptr);
+            ok = (options.threshold >= 0.0);
+        } else if (name == "--noise-factor") {
+            options.noise_factor = ::strtod(value, nullptr);
+            ok = (options.noise_factor >= 0.0);
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            fprintf(stderr, "Error: bad option: %s\n\n", arg);
+            return false;
+        }
+    }
+
+    if (files.size() != 2)
+        return false;
+    options.baseline = files[0];
+    options.current = files[1];
+    return true;
+}
+
+int main(int argc, char * argv[])
+{
+    CompareOptions options;
+    if (!parse_options(argc, argv, options)) {
+        print_usage(argv[0]);
+        return kExitBadInput;
+    }
+
+    std::vector<ComparePoint> baseline, current;
+    if (!load_results(options.baseline.c_str(), baseline) ||
+        !load_results(options.current.c_str(), current)) {
+        return kExitBadInput;
+    }
+
+    std::map<std::string, std::size_t> current_index;
+    for (std::size_t i = 0; i < current.size(); i++) {
+        current_index[current[i].key()] = i;
+    }
+
+    std::size_t compared = 0, regressions = 0, improvements = 0, missing = 0;
+    double worst_ratio = 0.0;
+    double log_ratio_sum = 0.0;
+
+    printf("\n");
+    printf(" baseline: %s (%u points)\n", options.baseline.c_str(), (uint32_t)baseline.size());
+    printf(" current:  %s (%u points)\n\n", options.current.c_str(), (uint32_t)current.size());
+    printf(" %-28s %5s %12s %12s %5s %11s %11s %8s %8s  %s\n",
+           "algorithm", "elem", "length", "offset", "align",
+           "base(ms)", "cur(ms)", "ratio", "thresh", "status");
+
+    for (std::size_t i = 0; i < baseline.size(); i++) {
+        const ComparePoint & base = baseline[i];
+        std::map<std::string, std::size_t>::const_iterator iter = current_index.find(base.key());
+        if (iter == current_index.end()) {
+            missing++;
+            printf(" %-28s %5" PRIu64 " %12" PRIu64 " %12" PRIu64 " %5" PRIu64 " %11.4f %11s %8s %8s  %s\n",
+                   base.algorithm.c_str(), base.elem_size, base.length, base.offset, base.align,
+                   base.median, "-", "-", "-", "missing");
+            continue;
+        }
+
+        const ComparePoint & cur = current[iter->second];
+        double ratio = cur.median / base.median;
+        double noise = ::sqrt(base.noise() * base.noise() + cur.noise() * cur.noise());
+        double threshold = std::max(options.threshold, options.noise_factor * noise);
+
+        const char * status = "ok";
+        if (ratio > 1.0 + threshold) {
+            status = "REGRESSION";
+            regressions++;
+        } else if (ratio < 1.0 / (1.0 + threshold)) {
+            status = "improved";
+            improvements++;
+        }
+
+        compared++;
+        log_ratio_sum += ::log(ratio);
+        if (ratio > worst_ratio)
+            worst_ratio = ratio;
+
+        if (options.show_all || ::strcmp(status, "ok") != 0) {
+            printf(" %-28s %5" PRIu64 " %12" PRIu64 " %12" PRIu64 " %5" PRIu64 " %11.4f %11.4f %7.3fx %7.1f%%  %s\n",
+                   base.algorithm.c_str(), base.elem_size, base.length, base.offset, base.align,
+                   base.median, cur.median, ratio, threshold * 100.0, status);
+        }
+    }
+
+    printf("\n");
+    printf(" compared: %u, regressions: %u, improvements: %u, missing: %u\n",
+           (uint32_t)compared, (uint32_t)regressions, (uint32_t)improvements, (uint32_t)missing);
+    if (compared > 0) {
+        printf(" geomean ratio: %0.3fx, worst ratio: %0.3fx\n",
+               ::exp(log_ratio_sum / (double)compared), worst_ratio);
+    }
+    printf("\n");
+
+    if (regressions != 0 || (missing != 0 && !options.ignore_missing))
+        return kExitRegression;
+    if (compared == 0)
+        return kExitBadInput;
+    return kExitOk;
+}
@@ -9,19 +9,153 @@
 #include <cstdint>
 #include <cstddef>
 #include <cstdbool>
+#include <iterator>
 #include <algorithm>
 #include <type_traits>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <vector>       // For std::_Vector_iterator<T>
+#endif
 
+#include "jstd/stddef.h"
 #include "jstd/FastMod.h"
+#include "jstd/RotateProbes.h"
 
 #ifndef ROTATE_USE_FAST_MOD
 #define ROTATE_USE_FAST_MOD     0
 #endif
 
+//
+// The swap loops of contiguous, trivially copyable ranges use jstd::simd::swap_ranges().
+//
+#if defined(__AVX2__)
+#ifndef ROTATE_USE_SIMD_SWAP
+#define ROTATE_USE_SIMD_SWAP    1
+#endif
+#else
+#undef  ROTATE_USE_SIMD_SWAP
+#define ROTATE_USE_SIMD_SWAP    0
+#endif
+
+#if ROTATE_USE_SIMD_SWAP
+#include "jstd/ArrayRotate_SIMD.h"
+#endif
+
 namespace jstd {
 
+//
+// Whether the iterator points to the contiguous memory, e.g. T *, std::vector<T>::iterator.
+//
+template <typename Iterator>
+struct is_contiguous_iterator : public std::false_type {};
+
+template <typename T>
+struct is_contiguous_iterator<T *> : public std::true_type {};
+
+template <typename T>
+struct is_contiguous_iterator<const T *> : public std::true_type {};
+
+#if defined(__GLIBCXX__)
+template <typename T, typename Container>
+struct is_contiguous_iterator<__gnu_cxx::__normal_iterator<T *, Container>> : public std::true_type {};
+#endif
+
+#if defined(_LIBCPP_VERSION)
+template <typename T>
+struct is_contiguous_iterator<std::__wrap_iter<T *>> : public std::true_type {};
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+template <typename Vector>
+struct is_contiguous_iterator<std::_Vector_iterator<Vector>> : public std::true_type {};
+
+template <typename Vector>
+struct is_contiguous_iterator<std::_Vector_const_iterator<Vector>> : public std::true_type {};
+#endif
+
 namespace detail {
 
+template <typename Iterator>
+struct use_simd_swap {
+    typedef typename std::iterator_traits<Iterator>::value_type value_type;
+
+    static const bool value = (ROTATE_USE_SIMD_SWAP != 0) &&
+                              is_contiguous_iterator<Iterator>::value &&
+                              std::is_trivially_copyable<value_type>::value;
+};
+
+template <typename Iterator>
+inline
+Iterator swap_ranges_forward(Iterator first1, Iterator last1, Iterator first2, std::false_type)
+{
+    while (first1 != last1) {
+        std::iter_swap(first1, first2);
+        ++first1;
+        ++first2;
+    }
+    return first2;
+}
+
+template <typename Iterator>
+inline
+Iterator swap_ranges_backward(Iterator first1, Iterator last1, Iterator last2, std::false_type)
+{
+    while (last1 != first1) {
+        --last1;
+        --last2;
+        std::iter_swap(last1, last2);
+    }
+    return last2;
+}
+
+#if ROTATE_USE_SIMD_SWAP
+
+template <typename Iterator>
+inline
+Iterator swap_ranges_forward(Iterator first1, Iterator last1, Iterator first2, std::true_type)
+{
+    std::size_t count = (std::size_t)(last1 - first1);
+    if (count != 0) {
+        jstd::simd::swap_ranges(&*first1, &*first2, count);
+    }
+    return (first2 + count);
+}
+
+template <typename Iterator>
+inline
+Iterator swap_ranges_backward(Iterator first1, Iterator last1, Iterator last2, std::true_type)
+{
+    std::size_t count = (std::size_t)(last1 - first1);
+    if (count != 0) {
+        // Don't dereference the end iterators.
+        jstd::simd::swap_ranges_backward(&*(last1 - 1) + 1, &*(last2 - 1) + 1, count);
+    }
+    return (last2 - count);
+}
+
+#endif // ROTATE_USE_SIMD_SWAP
+
+//
+// Swap [first1, last1) and [first2, ...) in ascending order, returns the end of the second range.
+//
+template <typename Iterator>
+inline
+Iterator swap_ranges_forward(Iterator first1, Iterator last1, Iterator first2)
+{
+    return swap_ranges_forward(first1, last1, first2,
+                               std::integral_constant<bool, use_simd_swap<Iterator>::value>());
+}
+
+//
+// Swap [first1, last1) and [..., last2) in descending order, returns the begin of the second range.
+//
+template <typename Iterator>
+inline
+Iterator swap_ranges_backward(Iterator first1, Iterator last1, Iterator last2)
+{
+    return swap_ranges_backward(first1, last1, last2,
+                                std::integral_constant<bool, use_simd_swap<Iterator>::value>());
+}
+
 //
 // Recursive version, not practical in actual use.
 //
@@ -151,7 +285,7 @@ std_rotate(RandomAccessIterator first, RandomAccessIterator middle, RandomAccess
     const difference_type left_len  = middle - first;
     const difference_type right_len = last - middle;
     if (left_len == right_len) {
-        std::swap_ranges(first, middle, middle);
+        swap_ranges_forward(first, middle, middle);
         return middle;
     }
 
@@ -200,7 +334,7 @@ libcxx_rotate(_RandomAccessIterator __first, _RandomAccessIterator __middle, _Ra
     const difference_type __left  = __middle - __first;
     const difference_type __right = __last - __middle;
     if (__left == __right) {
-        std::swap_ranges(__first, __middle, __middle);
+        detail::swap_ranges_forward(__first, __middle, __middle);
         return __middle;
     }
 
@@ -228,6 +362,249 @@ libcxx_rotate(_RandomAccessIterator __first, _RandomAccessIterator __middle, _Ra
 
 namespace detail {
 
+template <typename IndexType, typename Modulus, typename RandomAccessIterator>
+void fastmod_cycle_rotate_impl(RandomAccessIterator first, std::size_t left_len, std::size_t right_len)
+{
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type value_type;
+
+    std::size_t length = left_len + right_len;
+    IndexType shift = (IndexType)left_len;
+    Modulus modulus((IndexType)length);
+
+    std::size_t gcd = __gcd(left_len, right_len);
+    std::size_t cycle_len = length / gcd;
+
+    for (IndexType c = 0; c < (IndexType)gcd; c++) {
+        value_type tmp(std::move(first[c]));
+        IndexType index = c;
+        for (std::size_t step = 1; step < cycle_len; step++) {
+            IndexType next = modulus.modulus(index + shift);
+            first[index] = std::move(first[next]);
+            index = next;
+        }
+        first[index] = std::move(tmp);
+    }
+}
+
+} // namespace detail
+
+//
+// Same as libcxx_rotate(), but the next cycle index is (index + left) mod length,
+// computed with a FastModulus32 (Lemire's fastmod, precomputed once), instead of
+// the data-dependent branch "if (left < last - p2) ... else ...". It's only
+// multiplies, so there is nothing to mispredict for the irregular shifts.
+// Each cycle runs a fixed count of steps (length / gcd).
+//
+// The index must fit in 32 bits: (length - 1) + left < 2^32, otherwise uses
+// 64-bit indexes and a FastModulus64 (or falls back to libcxx_rotate() if
+// std::size_t is 32 bits).
+//
+template <typename RandomAccessIterator>
+RandomAccessIterator
+fastmod_cycle_rotate(RandomAccessIterator first, RandomAccessIterator middle, RandomAccessIterator last)
+{
+    typedef typename std::iterator_traits<RandomAccessIterator>::difference_type difference_type;
+
+    if (first == middle) return last;
+    if (middle == last) return first;
+
+    std::size_t left_len  = (std::size_t)difference_type(middle - first);
+    std::size_t right_len = (std::size_t)difference_type(last - middle);
+    if (left_len == right_len) {
+        detail::swap_ranges_forward(first, middle, middle);
+        return middle;
+    }
+
+    std::size_t length = left_len + right_len;
+    if (length < (std::size_t)0x80000000ul) {
+        detail::fastmod_cycle_rotate_impl<std::uint32_t, FastModulus32>(first, left_len, right_len);
+    } else {
+#if (SIZE_MAX > 0xFFFFFFFFul)
+        detail::fastmod_cycle_rotate_impl<std::uint64_t, FastModulus64>(first, left_len, right_len);
+#else
+        return libcxx_rotate(first, middle, last);
+#endif
+    }
+
+    return (first + right_len);
+}
+
+namespace detail {
+
+//
+// (a * b) % n without overflow, only be called once per cycle.
+//
+template <typename SizeType>
+inline
+SizeType mul_mod(SizeType a, SizeType b, SizeType n)
+{
+    SizeType result = 0;
+    a %= n;
+    while (b != 0) {
+        if (b & 1) {
+            result += a;
+            if (result >= n) result -= n;
+        }
+        a += a;
+        if (a >= n) a -= n;
+        b >>= 1;
+    }
+    return result;
+}
+
+//
+// Move the G adjacent cycles [c, c + G) in lockstep, needs gcd >= G.
+// All positions of cycle c are congruent to c modulo gcd, so the G positions
+// of one step never straddle the wrap point, they move as a block.
+//
+template <std::size_t G, typename RandomAccessIterator, typename SizeType>
+void rotate_cycles_lockstep(RandomAccessIterator first, SizeType c,
+                            SizeType left_len, SizeType right_len, SizeType cycle_len)
+{
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type value_type;
+
+    value_type tmp[G];
+    for (std::size_t j = 0; j < G; j++) {
+        tmp[j] = std::move(first[c + j]);
+    }
+
+    SizeType pos = c;
+    for (SizeType step = 1; step < cycle_len; step++) {
+        SizeType next = (pos >= right_len) ? (pos - right_len) : (pos + left_len);
+        for (std::size_t j = 0; j < G; j++) {
+            first[pos + j] = std::move(first[next + j]);
+        }
+        pos = next;
+    }
+
+    for (std::size_t j = 0; j < G; j++) {
+        first[pos + j] = std::move(tmp[j]);
+    }
+}
+
+//
+// Split one long cycle into G segments and move them in lockstep.
+// The head of each segment is saved first, because the tail of the previous
+// segment needs its original value, so the G dependent chains are independent.
+//
+template <std::size_t G, typename RandomAccessIterator, typename SizeType>
+void rotate_cycle_segmented(RandomAccessIterator first, SizeType c,
+                            SizeType left_len, SizeType right_len, SizeType cycle_len)
+{
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type value_type;
+
+    SizeType length = left_len + right_len;
+    SizeType seg_len = cycle_len / G;
+    SizeType seg_stride = mul_mod(seg_len, left_len, length);
+
+    SizeType pos[G];
+    value_type tmp[G];
+    pos[0] = c;
+    for (std::size_t m = 1; m < G; m++) {
+        SizeType next = pos[m - 1] + seg_stride;
+        pos[m] = (next >= length) ? (next - length) : next;
+    }
+    for (std::size_t m = 0; m < G; m++) {
+        tmp[m] = std::move(first[pos[m]]);
+    }
+
+    for (SizeType step = 1; step < seg_len; step++) {
+        for (std::size_t m = 0; m < G; m++) {
+            SizeType cur = pos[m];
+            SizeType next = (cur >= right_len) ? (cur - right_len) : (cur + left_len);
+            first[cur] = std::move(first[next]);
+            pos[m] = next;
+        }
+    }
+
+    // The last segment takes the remainder of (cycle_len / G).
+    SizeType cur = pos[G - 1];
+    for (SizeType step = seg_len * G; step < cycle_len; step++) {
+        SizeType next = (cur >= right_len) ? (cur - right_len) : (cur + left_len);
+        first[cur] = std::move(first[next]);
+        cur = next;
+    }
+    pos[G - 1] = cur;
+
+    for (std::size_t m = 0; m < G - 1; m++) {
+        first[pos[m]] = std::move(tmp[m + 1]);
+    }
+    first[pos[G - 1]] = std::move(tmp[0]);
+}
+
+} // namespace detail
+
+//
+// Cycle leader (juggling) rotation with G cycles in flight.
+//
+// libcxx_rotate() follows one gcd cycle at a time, every step depends on the cache miss
+// of the previous one. Here G cycles (gcd >= G), or G segments of one cycle (gcd < G),
+// advance in lockstep, so there are G independent misses in flight at once.
+//
+// G = 4 ~ 16 is reasonable, it's limited by the line fill buffers (10 ~ 12 on Intel cores).
+//
+template <std::size_t G = 8, typename RandomAccessIterator>
+RandomAccessIterator
+interleaved_cycle_rotate(RandomAccessIterator first, RandomAccessIterator middle, RandomAccessIterator last)
+{
+    typedef typename std::iterator_traits<RandomAccessIterator>::difference_type difference_type;
+
+    JSTD_STATIC_ASSERT((G >= 1), "jstd::interleaved_cycle_rotate<G>(): G must be >= 1.");
+
+    if (first == middle) return last;
+    if (middle == last) return first;
+
+    std::size_t left_len  = (std::size_t)difference_type(middle - first);
+    std::size_t right_len = (std::size_t)difference_type(last - middle);
+    if (left_len == right_len) {
+        detail::swap_ranges_forward(first, middle, middle);
+        return middle;
+    }
+
+    std::size_t length = left_len + right_len;
+    std::size_t gcd = __gcd(left_len, right_len);
+    std::size_t cycle_len = length / gcd;
+
+    std::size_t c = 0;
+    if (gcd >= G) {
+        for (; (c + G) <= gcd; c += G) {
+            detail::rotate_cycles_lockstep<G>(first, c, left_len, right_len, cycle_len);
+        }
+    }
+
+    for (; c < gcd; c++) {
+        if (cycle_len >= G * 2) {
+            detail::rotate_cycle_segmented<G>(first, c, left_len, right_len, cycle_len);
+        } else {
+            detail::std_rotate_cycle(first + c, first, last, (difference_type)left_len);
+        }
+    }
+
+    return (first + right_len);
+}
+
+namespace detail {
+
+#if ROTATE_USE_FAST_MOD
+
+//
+// The modulo of the Euclid steps, the 64-bit one only for the lengths >= 2^32.
+//
+static inline
+std::size_t rotate_fast_mod(std::size_t value, std::size_t divisor)
+{
+#if (SIZE_MAX > 0xFFFFFFFFul)
+    if (likely(value <= (std::size_t)0xFFFFFFFFul))
+        return fast_mod_u32_once((std::uint32_t)value, (std::uint32_t)divisor);
+    else
+        return (std::size_t)fast_mod_u64_once(value, divisor);
+#else
+    return fast_mod_u32_once((std::uint32_t)value, (std::uint32_t)divisor);
+#endif
+}
+
+#endif // ROTATE_USE_FAST_MOD
+
 template <typename RandomAccessIterator>
 RandomAccessIterator
 right_rotate(RandomAccessIterator first, RandomAccessIterator middle, RandomAccessIterator last,
@@ -250,13 +627,9 @@ right_rotate(RandomAccessIterator first, RandomAccessIterator middle, RandomAcce
             RandomAccessIterator read = middle;
             RandomAccessIterator write = last;
             if (right_len != 1) {
-                while (read != first) {
-                    --read;
-                    --write;
-                    std::iter_swap(read, write);
-                }
+                write = swap_ranges_backward(first, read, write);
 #if ROTATE_USE_FAST_MOD
-                left_len = fast_mod_u32((std::uint32_t)left_len, (std::uint32_t)right_len);
+                left_len = rotate_fast_mod(left_len, right_len);
 #else
                 left_len %= right_len;
 #endif
@@ -281,13 +654,9 @@ right_rotate(RandomAccessIterator first, RandomAccessIterator middle, RandomAcce
             RandomAccessIterator read = middle;
             RandomAccessIterator write = first;
             if (left_len != 1) {
-                while (read != last) {
-                    std::iter_swap(write, read);
-                    ++write;
-                    ++read;
-                }
+                write = swap_ranges_forward(read, last, write);
 #if ROTATE_USE_FAST_MOD
-                right_len = fast_mod_u32((std::uint32_t)right_len, (std::uint32_t)left_len);
+                right_len = rotate_fast_mod(right_len, left_len);
 #else
                 right_len %= left_len;
 #endif
@@ -375,13 +744,9 @@ left_rotate_bidirectional(BidirectionalIterator first, BidirectionalIterator mid
             iterator read = middle;
             iterator write = first;
             if (left_len != 1) {
-                while (read != last) {
-                    std::iter_swap(write, read);
-                    ++write;
-                    ++read;
-                }
+                write = swap_ranges_forward(read, last, write);
 #if ROTATE_USE_FAST_MOD
-                right_len = fast_mod_u32((std::uint32_t)right_len, (std::uint32_t)left_len);
+                right_len = rotate_fast_mod(right_len, left_len);
 #else
                 right_len %= left_len;
 #endif
@@ -409,13 +774,9 @@ left_rotate_bidirectional(BidirectionalIterator first, BidirectionalIterator mid
             iterator read = middle;
             iterator write = last;
             if (right_len != 1) {
-                while (read != first) {
-                    --read;
-                    --write;
-                    std::iter_swap(read, write);
-                }
+                write = swap_ranges_backward(first, read, write);
 #if ROTATE_USE_FAST_MOD
-                left_len = fast_mod_u32((std::uint32_t)left_len, (std::uint32_t)right_len);
+                left_len = rotate_fast_mod(left_len, right_len);
 #else
                 left_len %= right_len;
 #endif
@@ -509,7 +870,15 @@ inline
 RandomAccessIterator
 rotate(RandomAccessIterator first, RandomAccessIterator middle, RandomAccessIterator last, std::random_access_iterator_tag)
 {
-    return left_rotate(first, middle, last, std::random_access_iterator_tag());
+    // Only the random access iterators are probed, the distances are free.
+    JSTD_ROTATE_PROBE3(rotate_entry, std::size_t(last - first), std::size_t(middle - first),
+                       sizeof(typename std::iterator_traits<RandomAccessIterator>::value_type));
+
+    RandomAccessIterator result = left_rotate(first, middle, last, std::random_access_iterator_tag());
+
+    JSTD_ROTATE_PROBE3(rotate_exit, std::size_t(last - first), std::size_t(middle - first),
+                       sizeof(typename std::iterator_traits<RandomAccessIterator>::value_type));
+    return result;
 }
 
 } // namespace detail
@@ -0,0 +1,138 @@
+
+#ifndef JSTD_ARRAY_ROTATE_CALIBRATE_H
+#define JSTD_ARRAY_ROTATE_CALIBRATE_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdbool>
+#include <cstdlib>
+#include <chrono>
+
+#include "jstd/stddef.h"
+#include "jstd/ArrayRotate_Params.h"
+#include "jstd/ArrayRotate_SIMD.h"
+
+//
+// Calibrate the prefetch distance and hint level of the SIMD rotate kernels.
+//
+// Times the forward move kernel and the swap_ranges kernel over a buffer bigger
+// than the last level cache on most CPUs, for a short sweep of prefetch distances
+// and hint levels, and picks the fastest one. It takes about half a second,
+// call it once at startup, or on demand (e.g. after migrating to another node).
+//
+
+namespace jstd {
+namespace simd {
+
+struct RotateCalibrateResult {
+    RotateParams    params;
+    // The best time of the chosen parameters, and of the default parameters (unit: ms).
+    double          best_time;
+    double          default_time;
+};
+
+namespace detail {
+
+static const std::size_t kCalibrateBufferBytes = 64 * 1024 * 1024;
+static const int         kCalibrateRepeats = 3;
+
+// Keep the default parameters unless the best one is 2% faster at least, it's noise.
+static const double      kCalibrateMinGain = 0.02;
+
+inline double calibrate_time_kernels(std::uint32_t * data, std::size_t length,
+                                     const RotateParams & params)
+{
+    typedef std::chrono::steady_clock clock_type;
+
+    set_rotate_params(params);
+
+    double best_time = 0.0;
+    for (int repeat = 0; repeat < kCalibrateRepeats; repeat++) {
+        clock_type::time_point start_time = clock_type::now();
+
+        // Move [16, length) to [0, length - 16), the distance is 64 bytes.
+        avx_move_forward_N_load_aligned<std::uint32_t, 8>(data, data + 16, data + length);
+        std::size_t half = length / 2;
+        simd::swap_ranges(data, data + half, half);
+
+        clock_type::time_point end_time = clock_type::now();
+        double elapsed = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+        if (repeat == 0 || elapsed < best_time)
+            best_time = elapsed;
+    }
+    return best_time;
+}
+
+} // namespace detail
+
+inline RotateCalibrateResult
+calibrate_rotate_params(std::size_t buffer_bytes = detail::kCalibrateBufferBytes, bool apply = true)
+{
+    static const std::size_t kPrefetchOffsets[] = { 128, 256, 512, 1024, 2048 };
+    static const int kPrefetchHints[] = {
+        _MM_HINT_T0, _MM_HINT_T1, _MM_HINT_T2, _MM_HINT_NTA
+    };
+
+    RotateParams saved_params = get_rotate_params();
+
+    RotateCalibrateResult result;
+    result.params = RotateParams();
+    result.best_time = 0.0;
+    result.default_time = 0.0;
+
+    std::size_t length = buffer_bytes / sizeof(std::uint32_t);
+    std::uint32_t * data = (std::uint32_t *)std::malloc(length * sizeof(std::uint32_t));
+    if (data == nullptr || length < 1024) {
+        std::free(data);
+        set_rotate_params(saved_params);
+        return result;
+    }
+    for (std::size_t i = 0; i < length; i++) {
+        data[i] = (std::uint32_t)i;
+    }
+
+    // The first run is also the warm-up (page faults).
+    result.default_time = detail::calibrate_time_kernels(data, length, RotateParams());
+    result.default_time = detail::calibrate_time_kernels(data, length, RotateParams());
+    result.best_time = result.default_time;
+
+    double elapsed = detail::calibrate_time_kernels(data, length,
+                                                    RotateParams(0, kPrefetchHintNone));
+    if (elapsed < result.best_time) {
+        result.best_time = elapsed;
+        result.params = RotateParams(0, kPrefetchHintNone);
+    }
+
+    for (std::size_t i = 0; i < sizeof(kPrefetchOffsets) / sizeof(kPrefetchOffsets[0]); i++) {
+        for (std::size_t j = 0; j < sizeof(kPrefetchHints) / sizeof(kPrefetchHints[0]); j++) {
+            RotateParams params(kPrefetchOffsets[i], kPrefetchHints[j]);
+            elapsed = detail::calibrate_time_kernels(data, length, params);
+            if (elapsed < result.best_time) {
+                result.best_time = elapsed;
+                result.params = params;
+            }
+        }
+    }
+
+    std::free(data);
+
+    if (result.best_time > result.default_time * (1.0 - detail::kCalibrateMinGain)) {
+        result.params = RotateParams();
+        result.best_time = result.default_time;
+    }
+
+    if (apply)
+        set_rotate_params(result.params);
+    else
+        set_rotate_params(saved_params);
+    return result;
+}
+
+} // namespace simd
+} // namespace jstd
+
+#endif // JSTD_ARRAY_ROTATE_CALIBRATE_H
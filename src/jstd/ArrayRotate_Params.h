@@ -0,0 +1,419 @@
+
+#ifndef JSTD_ARRAY_ROTATE_PARAMS_H
+#define JSTD_ARRAY_ROTATE_PARAMS_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdbool>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <xmmintrin.h>      // For _mm_prefetch()
+
+#include "jstd/stddef.h"
+
+//
+// The runtime tuning parameters of the SIMD rotate kernels.
+//
+// The best prefetch distance and hint level are very different between CPUs
+// (e.g. Broadwell and Zen 4), so the kernels read them from a parameter block
+// instead of the compile-time constants. The default values are the same as
+// before (512 bytes, PREFETCH_HINT_LEVEL), jstd::simd::calibrate_rotate_params()
+// (see ArrayRotate_Calibrate.h) can measure better ones at startup or on demand.
+//
+// The kernel profile picks the forward move kernel of the AVX stash rotation
+// (left_rotate_avx_N_regs) per stash size and move size class, instead of the
+// hand-picked "#if 0 / #elif 1" blocks. It's written by the autotune target
+// and loaded at the first use from the file named by the JSTD_ROTATE_PROFILE
+// environment variable, if it's not set, the built-in choice is used.
+//
+// The parameter block is a process-wide setting, set it once before the rotations
+// run in other threads, it's not synchronized.
+//
+// Profile format (flat JSON, one value per key):
+//
+//   {
+//     "version": 1,
+//     "prefetch_offset": 512,
+//     "prefetch_hint": "T0",
+//     "size_limit_0": 32768,
+//     "size_limit_1": 1048576,
+//     "size_limit_2": 16777216,
+//     "stash_0.size_0": "store_aligned_8",
+//     ...
+//     "stash_2.size_3": "store_aligned_nt_4"
+//   }
+//
+// stash_0 is 1 - 6 stash registers, stash_1 is 7 - 8, stash_2 is 9 - 12;
+// size_N is the move size class, split by size_limit_0 .. size_limit_2 (bytes).
+//
+
+#ifndef PREFETCH_HINT_LEVEL
+#define PREFETCH_HINT_LEVEL     _MM_HINT_T0
+#endif
+
+namespace jstd {
+namespace simd {
+
+// The compile-time defaults of RotateParams.
+static const std::size_t kPrefetchOffset = 512;
+static const int kPrefetchHintLevel = PREFETCH_HINT_LEVEL;
+
+// Don't issue any prefetch.
+static const int kPrefetchHintNone = -1;
+
+struct RotateParams {
+    // The distance (in bytes) ahead of the source to prefetch.
+    std::size_t prefetch_offset;
+    // _MM_HINT_T0, _MM_HINT_T1, _MM_HINT_T2, _MM_HINT_NTA or kPrefetchHintNone.
+    int         prefetch_hint;
+
+    RotateParams() : prefetch_offset(kPrefetchOffset), prefetch_hint(kPrefetchHintLevel) {}
+    RotateParams(std::size_t offset, int hint) : prefetch_offset(offset), prefetch_hint(hint) {}
+};
+
+//
+// _mm_prefetch() needs a compile-time hint, dispatch the runtime one.
+// The hint is loop invariant in the kernels, the branch is always predicted.
+//
+JSTD_FORCED_INLINE
+void prefetch(const char * addr, int hint)
+{
+    switch (hint) {
+        case _MM_HINT_T0:
+            _mm_prefetch(addr, _MM_HINT_T0);
+            break;
+        case _MM_HINT_T1:
+            _mm_prefetch(addr, _MM_HINT_T1);
+            break;
+        case _MM_HINT_T2:
+            _mm_prefetch(addr, _MM_HINT_T2);
+            break;
+        case _MM_HINT_NTA:
+            _mm_prefetch(addr, _MM_HINT_NTA);
+            break;
+        default:
+            // kPrefetchHintNone
+            break;
+    }
+}
+
+inline const char * prefetch_hint_name(int hint)
+{
+    switch (hint) {
+        case _MM_HINT_T0:
+            return "T0";
+        case _MM_HINT_T1:
+            return "T1";
+        case _MM_HINT_T2:
+            return "T2";
+        case _MM_HINT_NTA:
+            return "NTA";
+        default:
+            return "None";
+    }
+}
+
+enum MoveKernelId {
+    kMoveKernelDefault,
+    kMoveLoadAligned4,
+    kMoveLoadAligned6,
+    kMoveLoadAligned8,
+    kMoveStoreAligned4,
+    kMoveStoreAligned6,
+    kMoveStoreAligned8,
+    kMoveStoreAlignedNT4,
+    kMoveStoreAlignedNT6,
+    kMoveStoreAlignedNT8,
+    kMoveNx2LoadAligned4,
+    kMoveNx2LoadAligned6,
+    kMoveNx2LoadAligned8,
+    kMoveNx2StoreAligned4,
+    kMoveNx2StoreAligned6,
+    kMoveNx2StoreAligned8,
+    kMoveKernelLast
+};
+
+static const std::size_t kStashClassCount = 3;
+static const std::size_t kSizeClassCount = 4;
+
+struct RotateProfile {
+    bool            loaded;
+    std::size_t     size_limits[kSizeClassCount - 1];
+    std::uint8_t    kernels[kStashClassCount][kSizeClassCount];
+
+    RotateProfile() : loaded(false) {
+        // About L1, L2 and L3 cache size.
+        size_limits[0] = 32 * 1024;
+        size_limits[1] = 1024 * 1024;
+        size_limits[2] = 16 * 1024 * 1024;
+        std::memset((void *)&kernels[0][0], kMoveKernelDefault, sizeof(kernels));
+    }
+
+    // Stash registers: 1 - 6: class 0, 7 - 8: class 1, 9 - 12: class 2.
+    static std::size_t stash_class(std::size_t stash_regs) {
+        return (stash_regs <= 6) ? 0 : ((stash_regs <= 8) ? 1 : 2);
+    }
+
+    std::size_t size_class(std::size_t move_bytes) const {
+        std::size_t size_class = 0;
+        while (size_class < kSizeClassCount - 1 && move_bytes > size_limits[size_class]) {
+            size_class++;
+        }
+        return size_class;
+    }
+
+    int select(std::size_t stash_class, std::size_t move_bytes) const {
+        return (int)kernels[stash_class][size_class(move_bytes)];
+    }
+};
+
+inline const char * move_kernel_name(int kernel)
+{
+    static const char * const kKernelNames[] = {
+        "default",
+        "load_aligned_4",
+        "load_aligned_6",
+        "load_aligned_8",
+        "store_aligned_4",
+        "store_aligned_6",
+        "store_aligned_8",
+        "store_aligned_nt_4",
+        "store_aligned_nt_6",
+        "store_aligned_nt_8",
+        "load_aligned_Nx2_4",
+        "load_aligned_Nx2_6",
+        "load_aligned_Nx2_8",
+        "store_aligned_Nx2_4",
+        "store_aligned_Nx2_6",
+        "store_aligned_Nx2_8"
+    };
+    JSTD_STATIC_ASSERT((sizeof(kKernelNames) / sizeof(kKernelNames[0]) == kMoveKernelLast),
+                       "move_kernel_name(): kKernelNames[] size is wrong.");
+    if (kernel >= 0 && kernel < kMoveKernelLast)
+        return kKernelNames[kernel];
+    else
+        return "unknown";
+}
+
+inline int move_kernel_from_name(const std::string & name)
+{
+    for (int kernel = 0; kernel < kMoveKernelLast; kernel++) {
+        if (name == move_kernel_name(kernel))
+            return kernel;
+    }
+    return -1;
+}
+
+inline int prefetch_hint_from_name(const std::string & name)
+{
+    if (name == "T0")
+        return _MM_HINT_T0;
+    else if (name == "T1")
+        return _MM_HINT_T1;
+    else if (name == "T2")
+        return _MM_HINT_T2;
+    else if (name == "NTA")
+        return _MM_HINT_NTA;
+    else
+        return kPrefetchHintNone;
+}
+
+namespace detail {
+
+//
+// Read a flat JSON object: { "key": number or "string", ... },
+// nested objects and arrays are not supported.
+//
+template <typename Visitor>
+bool parse_flat_json(const std::string & text, Visitor & visitor)
+{
+    std::size_t pos = text.find('{');
+    if (pos == std::string::npos)
+        return false;
+    pos++;
+
+    while (pos < text.size()) {
+        std::size_t key_first = text.find_first_of("\"}", pos);
+        if (key_first == std::string::npos)
+            return false;
+        if (text[key_first] == '}')
+            return true;
+        std::size_t key_last = text.find('"', key_first + 1);
+        if (key_last == std::string::npos)
+            return false;
+        std::string key = text.substr(key_first + 1, key_last - key_first - 1);
+
+        std::size_t colon = text.find(':', key_last + 1);
+        if (colon == std::string::npos)
+            return false;
+        std::size_t value_first = text.find_first_not_of(" \t\r\n", colon + 1);
+        if (value_first == std::string::npos)
+            return false;
+
+        if (text[value_first] == '"') {
+            std::size_t value_last = text.find('"', value_first + 1);
+            if (value_last == std::string::npos)
+                return false;
+            visitor(key, text.substr(value_first + 1, value_last - value_first - 1), 0);
+            pos = value_last + 1;
+        } else {
+            char * number_end = nullptr;
+            unsigned long long number = std::strtoull(text.c_str() + value_first, &number_end, 10);
+            if (number_end == text.c_str() + value_first)
+                return false;
+            visitor(key, std::string(), (std::size_t)number);
+            pos = (std::size_t)(number_end - text.c_str());
+        }
+    }
+    return false;
+}
+
+struct RotateProfileVisitor {
+    RotateParams &  params;
+    RotateProfile & profile;
+    std::size_t     kernel_count;
+
+    RotateProfileVisitor(RotateParams & _params, RotateProfile & _profile)
+        : params(_params), profile(_profile), kernel_count(0) {}
+
+    void operator () (const std::string & key, const std::string & str_value, std::size_t value) {
+        unsigned int stash_class, size_class;
+        if (key == "prefetch_offset") {
+            params.prefetch_offset = value;
+        } else if (key == "prefetch_hint") {
+            params.prefetch_hint = prefetch_hint_from_name(str_value);
+        } else if (std::sscanf(key.c_str(), "size_limit_%u", &size_class) == 1) {
+            if (size_class < kSizeClassCount - 1)
+                profile.size_limits[size_class] = value;
+        } else if (std::sscanf(key.c_str(), "stash_%u.size_%u", &stash_class, &size_class) == 2) {
+            int kernel = move_kernel_from_name(str_value);
+            if (stash_class < kStashClassCount && size_class < kSizeClassCount && kernel >= 0) {
+                profile.kernels[stash_class][size_class] = (std::uint8_t)kernel;
+                kernel_count++;
+            }
+        }
+    }
+};
+
+} // namespace detail
+
+inline bool load_rotate_profile(const char * filename, RotateParams & params, RotateProfile & profile)
+{
+    if (filename == nullptr || filename[0] == '\0')
+        return false;
+
+    std::FILE * fp = std::fopen(filename, "rb");
+    if (fp == nullptr)
+        return false;
+
+    std::string text;
+    char buffer[4096];
+    std::size_t read_bytes;
+    while ((read_bytes = std::fread(buffer, 1, sizeof(buffer), fp)) != 0) {
+        text.append(buffer, read_bytes);
+    }
+    std::fclose(fp);
+
+    RotateParams new_params;
+    RotateProfile new_profile;
+    detail::RotateProfileVisitor visitor(new_params, new_profile);
+    if (!detail::parse_flat_json(text, visitor))
+        return false;
+
+    new_profile.loaded = (visitor.kernel_count != 0);
+    params = new_params;
+    profile = new_profile;
+    return true;
+}
+
+inline bool save_rotate_profile(const char * filename, const RotateParams & params,
+                                const RotateProfile & profile)
+{
+    std::FILE * fp = std::fopen(filename, "wb");
+    if (fp == nullptr)
+        return false;
+
+    std::fprintf(fp, "{\n");
+    std::fprintf(fp, "  \"version\": 1,\n");
+    std::fprintf(fp, "  \"prefetch_offset\": %u,\n", (unsigned int)params.prefetch_offset);
+    std::fprintf(fp, "  \"prefetch_hint\": \"%s\",\n", prefetch_hint_name(params.prefetch_hint));
+    for (std::size_t size_class = 0; size_class < kSizeClassCount - 1; size_class++) {
+        std::fprintf(fp, "  \"size_limit_%u\": %u,\n", (unsigned int)size_class,
+                     (unsigned int)profile.size_limits[size_class]);
+    }
+    for (std::size_t stash_class = 0; stash_class < kStashClassCount; stash_class++) {
+        for (std::size_t size_class = 0; size_class < kSizeClassCount; size_class++) {
+            bool is_last = (stash_class == kStashClassCount - 1) && (size_class == kSizeClassCount - 1);
+            std::fprintf(fp, "  \"stash_%u.size_%u\": \"%s\"%s\n",
+                         (unsigned int)stash_class, (unsigned int)size_class,
+                         move_kernel_name(profile.kernels[stash_class][size_class]),
+                         is_last ? "" : ",");
+        }
+    }
+    std::fprintf(fp, "}\n");
+
+    bool write_ok = (std::ferror(fp) == 0);
+    std::fclose(fp);
+    return write_ok;
+}
+
+namespace detail {
+
+struct RotateSettings {
+    RotateParams    params;
+    RotateProfile   profile;
+
+    RotateSettings() {
+        load_rotate_profile(std::getenv("JSTD_ROTATE_PROFILE"), this->params, this->profile);
+    }
+};
+
+inline RotateSettings & rotate_settings()
+{
+    static RotateSettings s_rotate_settings;
+    return s_rotate_settings;
+}
+
+} // namespace detail
+
+inline const RotateParams & get_rotate_params()
+{
+    return detail::rotate_settings().params;
+}
+
+inline void set_rotate_params(const RotateParams & params)
+{
+    detail::rotate_settings().params = params;
+}
+
+inline void reset_rotate_params()
+{
+    detail::rotate_settings().params = RotateParams();
+}
+
+inline const RotateProfile & get_rotate_profile()
+{
+    return detail::rotate_settings().profile;
+}
+
+inline void set_rotate_profile(const RotateProfile & profile)
+{
+    detail::rotate_settings().profile = profile;
+}
+
+inline void reset_rotate_profile()
+{
+    detail::rotate_settings().profile = RotateProfile();
+}
+
+} // namespace simd
+} // namespace jstd
+
+#endif // JSTD_ARRAY_ROTATE_PARAMS_H
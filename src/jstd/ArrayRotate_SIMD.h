@@ -16,9 +16,21 @@
 
 #include "jstd/stddef.h"
 #include "jstd/BitVec.h"
+#include "jstd/ArrayRotate_Params.h"
+#include "jstd/TraceScope.h"
+#include "jstd/RotateStats.h"
+#include "jstd/RotateProbes.h"
 
 #define USE_COMPILER_BARRIER    1
 
+//
+// Whether the AVX stash rotation picks the move kernel from the runtime
+// kernel profile (see ArrayRotate_Params.h), or only the built-in choice.
+//
+#ifndef ROTATE_USE_TUNED_PROFILE
+#define ROTATE_USE_TUNED_PROFILE    1
+#endif
+
 #if USE_COMPILER_BARRIER
 #ifndef jstd_compiler_barrier
 #define jstd_compiler_barrier()     std::atomic_signal_fence(std::memory_order_release);
@@ -40,10 +52,9 @@
 //   rw: (1) is preparing for a write, or (0) is preparing for a read;
 //   locality: prefetch hint level, default value is 3 (_MM_HINT_T2).
 //
-
-#ifndef PREFETCH_HINT_LEVEL
-#define PREFETCH_HINT_LEVEL     _MM_HINT_T0
-#endif
+// The default hint level (PREFETCH_HINT_LEVEL) and distance (kPrefetchOffset) are
+// in ArrayRotate_Params.h, the kernels use the runtime values of get_rotate_params().
+//
 
 //
 // TLB miss and L3 Cache miss
@@ -66,13 +77,6 @@ namespace jstd {
 namespace simd {
 
 static const bool kUsePrefetchHint = true;
-static const std::size_t kPrefetchOffset = 512;
-
-#if defined(JSTD_IS_PURE_GCC)
-static const enum _mm_hint kPrefetchHintLevel = PREFETCH_HINT_LEVEL;
-#else
-static const int kPrefetchHintLevel = PREFETCH_HINT_LEVEL;
-#endif
 
 ///////////////////////////////////////////////
 
@@ -132,6 +136,276 @@ static const bool kDestIsNotAligned = false;
 
 ///////////////////////////////////////////////
 
+//
+// Swap two ranges with AVX registers.
+//
+// The scalar loop swaps the elements one by one, so when the two ranges overlap,
+// the result depends on the order. A block of the SIMD loop is exactly the same
+// as the scalar loop when the distance of the two ranges is not less than the
+// block size, otherwise the smaller blocks or the scalar loop are used.
+//
+template <bool kFirstIsAligned>
+static JSTD_FORCED_INLINE
+__m256i _mm256_load_maybe_aligned(const char * addr)
+{
+    if (kFirstIsAligned)
+        return _mm256_load_si256((const __m256i *)addr);
+    else
+        return _mm256_loadu_si256((const __m256i *)addr);
+}
+
+template <bool kFirstIsAligned>
+static JSTD_FORCED_INLINE
+void _mm256_store_maybe_aligned(char * addr, __m256i value)
+{
+    if (kFirstIsAligned)
+        _mm256_store_si256((__m256i *)addr, value);
+    else
+        _mm256_storeu_si256((__m256i *)addr, value);
+}
+
+template <bool kFirstIsAligned>
+static inline
+std::size_t avx_swap_ranges_forward_loop(char * first1, char * first2,
+                                         std::size_t total_bytes, std::size_t distance)
+{
+    const std::size_t prefetch_offset = get_rotate_params().prefetch_offset;
+    const int prefetch_hint = get_rotate_params().prefetch_hint;
+
+    std::size_t offset = 0;
+    if (distance >= kAVXRegBytes * 2) {
+        std::size_t limit = total_bytes & ~(kAVXRegBytes * 2 - 1);
+        while (offset < limit) {
+            __m256i ymm0 = _mm256_load_maybe_aligned<kFirstIsAligned>(first1 + offset);
+            __m256i ymm1 = _mm256_load_maybe_aligned<kFirstIsAligned>(first1 + offset + kAVXRegBytes);
+            __m256i ymm2 = _mm256_loadu_si256((const __m256i *)(first2 + offset));
+            __m256i ymm3 = _mm256_loadu_si256((const __m256i *)(first2 + offset + kAVXRegBytes));
+
+            if (kUsePrefetchHint) {
+                prefetch((const char *)(first1 + offset + prefetch_offset), prefetch_hint);
+                prefetch((const char *)(first2 + offset + prefetch_offset), prefetch_hint);
+            }
+
+            _mm256_store_maybe_aligned<kFirstIsAligned>(first1 + offset, ymm2);
+            _mm256_store_maybe_aligned<kFirstIsAligned>(first1 + offset + kAVXRegBytes, ymm3);
+            _mm256_storeu_si256((__m256i *)(first2 + offset), ymm0);
+            _mm256_storeu_si256((__m256i *)(first2 + offset + kAVXRegBytes), ymm1);
+            offset += kAVXRegBytes * 2;
+        }
+    }
+
+    std::size_t limit = total_bytes & ~kAVXAlignMask;
+    while (offset < limit) {
+        __m256i ymm0 = _mm256_load_maybe_aligned<kFirstIsAligned>(first1 + offset);
+        __m256i ymm1 = _mm256_loadu_si256((const __m256i *)(first2 + offset));
+        _mm256_store_maybe_aligned<kFirstIsAligned>(first1 + offset, ymm1);
+        _mm256_storeu_si256((__m256i *)(first2 + offset), ymm0);
+        offset += kAVXRegBytes;
+    }
+    return offset;
+}
+
+template <bool kFirstIsAligned>
+static inline
+std::size_t avx_swap_ranges_backward_loop(char * last1, char * last2,
+                                          std::size_t total_bytes, std::size_t distance)
+{
+    const std::size_t prefetch_offset = get_rotate_params().prefetch_offset;
+    const int prefetch_hint = get_rotate_params().prefetch_hint;
+
+    std::size_t offset = 0;
+    if (distance >= kAVXRegBytes * 2) {
+        std::size_t limit = total_bytes & ~(kAVXRegBytes * 2 - 1);
+        while (offset < limit) {
+            offset += kAVXRegBytes * 2;
+            __m256i ymm0 = _mm256_load_maybe_aligned<kFirstIsAligned>(last1 - offset);
+            __m256i ymm1 = _mm256_load_maybe_aligned<kFirstIsAligned>(last1 - offset + kAVXRegBytes);
+            __m256i ymm2 = _mm256_loadu_si256((const __m256i *)(last2 - offset));
+            __m256i ymm3 = _mm256_loadu_si256((const __m256i *)(last2 - offset + kAVXRegBytes));
+
+            if (kUsePrefetchHint) {
+                prefetch((const char *)(last1 - offset - prefetch_offset), prefetch_hint);
+                prefetch((const char *)(last2 - offset - prefetch_offset), prefetch_hint);
+            }
+
+            _mm256_store_maybe_aligned<kFirstIsAligned>(last1 - offset, ymm2);
+            _mm256_store_maybe_aligned<kFirstIsAligned>(last1 - offset + kAVXRegBytes, ymm3);
+            _mm256_storeu_si256((__m256i *)(last2 - offset), ymm0);
+            _mm256_storeu_si256((__m256i *)(last2 - offset + kAVXRegBytes), ymm1);
+        }
+    }
+
+    std::size_t limit = total_bytes & ~kAVXAlignMask;
+    while (offset < limit) {
+        offset += kAVXRegBytes;
+        __m256i ymm0 = _mm256_load_maybe_aligned<kFirstIsAligned>(last1 - offset);
+        __m256i ymm1 = _mm256_loadu_si256((const __m256i *)(last2 - offset));
+        _mm256_store_maybe_aligned<kFirstIsAligned>(last1 - offset, ymm1);
+        _mm256_storeu_si256((__m256i *)(last2 - offset), ymm0);
+    }
+    return offset;
+}
+
+template <typename T>
+static inline
+T * swap_ranges_impl(T * first1, T * first2, std::size_t count, std::true_type /* is_trivially_copyable */)
+{
+    static const std::size_t kValueSize = sizeof(T);
+    static const bool kValueSizeIsDivisible = (kValueSize < kAVXRegBytes) ?
+                                              ((kAVXRegBytes % kValueSize) == 0) : false;
+
+    T * last2 = first2 + count;
+    std::size_t distance = (first1 < first2) ? std::size_t((char *)first2 - (char *)first1)
+                                             : std::size_t((char *)first1 - (char *)first2);
+    if (distance >= kAVXRegBytes && count * kValueSize >= kAVXRegBytes * 2) {
+        // Peel the head until first1 is aligned to 32 bytes, if it's possible.
+        std::size_t unaligned_bytes = (std::size_t)first1 & kAVXAlignMask;
+        bool can_align = kValueSizeIsDivisible && ((unaligned_bytes % kValueSize) == 0);
+        if (can_align) {
+            std::size_t padding_bytes = (kAVXRegBytes - unaligned_bytes) & kAVXAlignMask;
+            while (padding_bytes != 0) {
+                std::swap(*first1++, *first2++);
+                padding_bytes -= kValueSize;
+                count--;
+            }
+        }
+
+        std::size_t total_bytes = count * kValueSize;
+        std::size_t swapped_bytes;
+        if (can_align)
+            swapped_bytes = avx_swap_ranges_forward_loop<kIsAligned>((char *)first1, (char *)first2, total_bytes, distance);
+        else
+            swapped_bytes = avx_swap_ranges_forward_loop<kIsNotAligned>((char *)first1, (char *)first2, total_bytes, distance);
+
+        std::size_t swapped = swapped_bytes / kValueSize;
+        first1 += swapped;
+        first2 += swapped;
+        count -= swapped;
+
+        // If kValueSize is not a power of 2, the loop may stop in a value,
+        // swap the rest bytes of it.
+        std::size_t partial_bytes = swapped_bytes % kValueSize;
+        if (partial_bytes != 0) {
+            char * bytes1 = (char *)first1;
+            char * bytes2 = (char *)first2;
+            for (std::size_t i = partial_bytes; i < kValueSize; i++) {
+                std::swap(bytes1[i], bytes2[i]);
+            }
+            first1++;
+            first2++;
+            count--;
+        }
+    }
+
+    while (count != 0) {
+        std::swap(*first1++, *first2++);
+        count--;
+    }
+    return last2;
+}
+
+template <typename T>
+static inline
+T * swap_ranges_impl(T * first1, T * first2, std::size_t count, std::false_type /* is_trivially_copyable */)
+{
+    return std::swap_ranges(first1, first1 + count, first2);
+}
+
+template <typename T>
+static inline
+T * swap_ranges_backward_impl(T * last1, T * last2, std::size_t count, std::true_type /* is_trivially_copyable */)
+{
+    static const std::size_t kValueSize = sizeof(T);
+    static const bool kValueSizeIsDivisible = (kValueSize < kAVXRegBytes) ?
+                                              ((kAVXRegBytes % kValueSize) == 0) : false;
+
+    T * first2 = last2 - count;
+    std::size_t distance = (last1 < last2) ? std::size_t((char *)last2 - (char *)last1)
+                                           : std::size_t((char *)last1 - (char *)last2);
+    if (distance >= kAVXRegBytes && count * kValueSize >= kAVXRegBytes * 2) {
+        // Peel the tail until last1 is aligned to 32 bytes, if it's possible.
+        std::size_t unaligned_bytes = (std::size_t)last1 & kAVXAlignMask;
+        bool can_align = kValueSizeIsDivisible && ((unaligned_bytes % kValueSize) == 0);
+        if (can_align) {
+            std::size_t padding_bytes = unaligned_bytes;
+            while (padding_bytes != 0) {
+                std::swap(*--last1, *--last2);
+                padding_bytes -= kValueSize;
+                count--;
+            }
+        }
+
+        std::size_t total_bytes = count * kValueSize;
+        std::size_t swapped_bytes;
+        if (can_align)
+            swapped_bytes = avx_swap_ranges_backward_loop<kIsAligned>((char *)last1, (char *)last2, total_bytes, distance);
+        else
+            swapped_bytes = avx_swap_ranges_backward_loop<kIsNotAligned>((char *)last1, (char *)last2, total_bytes, distance);
+
+        std::size_t swapped = swapped_bytes / kValueSize;
+        last1 -= swapped;
+        last2 -= swapped;
+        count -= swapped;
+
+        // If kValueSize is not a power of 2, the loop may stop in a value,
+        // swap the rest bytes of it.
+        std::size_t partial_bytes = swapped_bytes % kValueSize;
+        if (partial_bytes != 0) {
+            --last1;
+            --last2;
+            char * bytes1 = (char *)last1;
+            char * bytes2 = (char *)last2;
+            for (std::size_t i = 0; i < kValueSize - partial_bytes; i++) {
+                std::swap(bytes1[i], bytes2[i]);
+            }
+            count--;
+        }
+    }
+
+    while (count != 0) {
+        std::swap(*--last1, *--last2);
+        count--;
+    }
+    return first2;
+}
+
+template <typename T>
+static inline
+T * swap_ranges_backward_impl(T * last1, T * last2, std::size_t count, std::false_type /* is_trivially_copyable */)
+{
+    while (count != 0) {
+        std::swap(*--last1, *--last2);
+        count--;
+    }
+    return last2;
+}
+
+//
+// Same as std::swap_ranges(first1, first1 + count, first2), in ascending order.
+// Returns (first2 + count).
+//
+template <typename T>
+inline
+T * swap_ranges(T * first1, T * first2, std::size_t count)
+{
+    return swap_ranges_impl(first1, first2, count,
+                            std::integral_constant<bool, std::is_trivially_copyable<T>::value>());
+}
+
+//
+// Swap [last1 - count, last1) and [last2 - count, last2), in descending order.
+// Returns (last2 - count).
+//
+template <typename T>
+inline
+T * swap_ranges_backward(T * last1, T * last2, std::size_t count)
+{
+    return swap_ranges_backward_impl(last1, last2, count,
+                                     std::integral_constant<bool, std::is_trivially_copyable<T>::value>());
+}
+
+///////////////////////////////////////////////
+
 template <typename T>
 T * right_rotate_simple_impl(T * first, T * mid, T * last,
                              std::size_t left_len, std::size_t right_len)
@@ -146,11 +420,7 @@ T * right_rotate_simple_impl(T * first, T * mid, T * last,
             pointer read = mid;
             pointer write = last;
             if (right_len != 1) {
-                while (read != first) {
-                    --read;
-                    --write;
-                    std::iter_swap(read, write);
-                }
+                write = swap_ranges_backward(read, write, left_len);
 
                 left_len %= right_len;
                 last = write;
@@ -174,11 +444,7 @@ T * right_rotate_simple_impl(T * first, T * mid, T * last,
             pointer read = mid;
             pointer write = first;
             if (left_len != 1) {
-                while (read != last) {
-                    std::iter_swap(write, read);
-                    ++write;
-                    ++read;
-                }
+                write = swap_ranges(read, write, right_len);
 
                 right_len %= left_len;
                 first = write;
@@ -265,11 +531,7 @@ T * left_rotate_simple_impl(T * first, T * mid, T * last,
             pointer read = mid;
             pointer write = first;
             if (left_len != 1) {
-                while (read != last) {
-                    std::swap(*write, *read);
-                    ++write;
-                    ++read;
-                }
+                write = swap_ranges(read, write, right_len);
                 right_len %= left_len;
                 first = write;
                 left_len -= right_len;
@@ -290,11 +552,7 @@ T * left_rotate_simple_impl(T * first, T * mid, T * last,
             pointer read = mid;
             pointer write = last;
             if (right_len != 1) {
-                while (read != first) {
-                    --read;
-                    --write;
-                    std::swap(*read, *write);
-                }
+                write = swap_ranges_backward(read, write, left_len);
                 left_len %= right_len;
                 last = write;
                 right_len -= left_len;
@@ -378,10 +636,204 @@ T * rotate_simple(T * data, std::size_t length, std::size_t offset)
     return left_rotate_simple(data, length, offset);
 }
 
+//
+// Reverse the elements in the AVX / SSE registers, for each element size.
+//
+template <std::size_t ValueSize>
+struct simd_reverse_kernel {
+    static const bool kSupported = false;
+};
+
+template <>
+struct simd_reverse_kernel<1> {
+    static const bool kSupported = true;
+
+    static JSTD_FORCED_INLINE
+    __m128i reverse(__m128i src) {
+        const __m128i kReverseMask = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+        return _mm_shuffle_epi8(src, kReverseMask);
+    }
+
+    // vpshufb only shuffles inside the 128-bit lanes, then swap the two lanes.
+    static JSTD_FORCED_INLINE
+    __m256i reverse(__m256i src) {
+        const __m256i kReverseMask = _mm256_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+                                                      15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+        __m256i result = _mm256_shuffle_epi8(src, kReverseMask);
+        return _mm256_permute4x64_epi64(result, 0x4E);
+    }
+};
+
+template <>
+struct simd_reverse_kernel<2> {
+    static const bool kSupported = true;
+
+    static JSTD_FORCED_INLINE
+    __m128i reverse(__m128i src) {
+        const __m128i kReverseMask = _mm_setr_epi8(14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1);
+        return _mm_shuffle_epi8(src, kReverseMask);
+    }
+
+    static JSTD_FORCED_INLINE
+    __m256i reverse(__m256i src) {
+        const __m256i kReverseMask = _mm256_setr_epi8(14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1,
+                                                      14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1);
+        __m256i result = _mm256_shuffle_epi8(src, kReverseMask);
+        return _mm256_permute4x64_epi64(result, 0x4E);
+    }
+};
+
+template <>
+struct simd_reverse_kernel<4> {
+    static const bool kSupported = true;
+
+    static JSTD_FORCED_INLINE
+    __m128i reverse(__m128i src) {
+        return _mm_shuffle_epi32(src, 0x1B);
+    }
+
+    static JSTD_FORCED_INLINE
+    __m256i reverse(__m256i src) {
+        const __m256i kReverseIndex = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+        return _mm256_permutevar8x32_epi32(src, kReverseIndex);
+    }
+};
+
+template <>
+struct simd_reverse_kernel<8> {
+    static const bool kSupported = true;
+
+    static JSTD_FORCED_INLINE
+    __m128i reverse(__m128i src) {
+        return _mm_shuffle_epi32(src, 0x4E);
+    }
+
+    static JSTD_FORCED_INLINE
+    __m256i reverse(__m256i src) {
+        return _mm256_permute4x64_epi64(src, 0x1B);
+    }
+};
+
+template <>
+struct simd_reverse_kernel<16> {
+    static const bool kSupported = true;
+
+    static JSTD_FORCED_INLINE
+    __m128i reverse(__m128i src) {
+        return src;
+    }
+
+    static JSTD_FORCED_INLINE
+    __m256i reverse(__m256i src) {
+        return _mm256_permute2x128_si256(src, src, 0x01);
+    }
+};
+
+//
+// Walk from both ends, swap and reverse 32 bytes per side in each step.
+// All loads and stores are unaligned, so the misaligned head and tail
+// need no scalar peeling. The middle part (less than 64 bytes) is done
+// by a pair of overlapping loads/stores: the overlapped bytes are written
+// twice with the same values, because both stores are the exact reversal.
+//
+template <typename T>
+static inline
+void reverse_impl(T * first, T * last, std::true_type /* is_supported */)
+{
+    typedef simd_reverse_kernel<sizeof(T)> kernel;
+
+    char * head = (char *)first;
+    char * tail = (char *)last;
+
+    while ((std::size_t)(tail - head) >= kAVXRegBytes * 2) {
+        tail -= kAVXRegBytes;
+        __m256i ymm0 = _mm256_loadu_si256((const __m256i *)head);
+        __m256i ymm1 = _mm256_loadu_si256((const __m256i *)tail);
+        ymm0 = kernel::reverse(ymm0);
+        ymm1 = kernel::reverse(ymm1);
+        _mm256_storeu_si256((__m256i *)head, ymm1);
+        _mm256_storeu_si256((__m256i *)tail, ymm0);
+        head += kAVXRegBytes;
+    }
+
+    std::size_t middle_bytes = (std::size_t)(tail - head);
+    if (middle_bytes >= kAVXRegBytes) {
+        __m256i ymm0 = _mm256_loadu_si256((const __m256i *)head);
+        __m256i ymm1 = _mm256_loadu_si256((const __m256i *)(tail - kAVXRegBytes));
+        ymm0 = kernel::reverse(ymm0);
+        ymm1 = kernel::reverse(ymm1);
+        _mm256_storeu_si256((__m256i *)head, ymm1);
+        _mm256_storeu_si256((__m256i *)(tail - kAVXRegBytes), ymm0);
+    } else if (middle_bytes >= kSSERegBytes) {
+        __m128i xmm0 = _mm_loadu_si128((const __m128i *)head);
+        __m128i xmm1 = _mm_loadu_si128((const __m128i *)(tail - kSSERegBytes));
+        xmm0 = kernel::reverse(xmm0);
+        xmm1 = kernel::reverse(xmm1);
+        _mm_storeu_si128((__m128i *)head, xmm1);
+        _mm_storeu_si128((__m128i *)(tail - kSSERegBytes), xmm0);
+    } else if (sizeof(T) < kSSERegBytes) {
+        // Less than 16 bytes, at most one 16-byte element left.
+        std::reverse((T *)head, (T *)tail);
+    }
+}
+
+template <typename T>
+static inline
+void reverse_impl(T * first, T * last, std::false_type /* is_supported */)
+{
+    std::reverse(first, last);
+}
+
+template <typename T>
+inline
+void reverse(T * first, T * last)
+{
+    // If (first > last), it's a error under DEBUG mode.
+    JSTD_ASSERT_EX((first <= last), "simd::reverse(): Error, first > last.");
+
+    typedef std::integral_constant<bool, (simd_reverse_kernel<sizeof(T)>::kSupported &&
+                                          std::is_trivially_copyable<T>::value)> is_supported;
+    reverse_impl(first, last, is_supported());
+}
+
+//
+// The triple reversal rotation, only for comparing with the stash approach.
+//
+template <typename T>
+inline
+T * rotate_reversal(T * first, T * mid, T * last)
+{
+    // If (first > mid), it's a error under DEBUG mode.
+    JSTD_ASSERT_EX((first <= mid), "simd::rotate_reversal(): Error, first > mid.");
+    // If (mid > last), it's a error under DEBUG mode.
+    JSTD_ASSERT_EX((mid <= last), "simd::rotate_reversal(): Error, mid > last.");
+
+    if (first == mid) return last;
+    if (mid == last) return first;
+
+    reverse(first, mid);
+    reverse(mid, last);
+    reverse(first, last);
+    return (first + (last - mid));
+}
+
+template <typename T>
+inline
+T * rotate_reversal(T * data, std::size_t length, std::size_t offset)
+{
+    return rotate_reversal(data, data + offset, data + length);
+}
+
+//
+// The forward move kernels: dest is always before src and the two ranges overlap
+// (dest = first, src = mid), so there is no JSTD_RESTRICT on the pointers, else
+// the compiler may vectorize the scalar peeling and tailing loops as if they don't
+// overlap, it's wrong when (src - dest) is less than the vector size (e.g. uint8_t).
+//
 template <typename T, bool srcIsAligned, bool destIsAligned, int LeftUints = 7>
 static
 JSTD_NO_INLINE
-void avx_move_forward_N_tailing(char * JSTD_RESTRICT dest, char * JSTD_RESTRICT src, char * JSTD_RESTRICT end)
+void avx_move_forward_N_tailing(char * dest, char * src, char * end)
 {
     static const std::size_t kValueSize = sizeof(T);
     JSTD_ASSERT(end >= src);
@@ -651,7 +1103,7 @@ void avx_move_forward_N_tailing(char * JSTD_RESTRICT dest, char * JSTD_RESTRICT
 template <typename T, bool srcIsAligned, bool destIsAligned, int LeftUints = 7>
 static
 JSTD_NO_INLINE
-void avx_move_forward_N_tailing_nt(char * JSTD_RESTRICT dest, char * JSTD_RESTRICT src, char * JSTD_RESTRICT end)
+void avx_move_forward_N_tailing_nt(char * dest, char * src, char * end)
 {
     static const std::size_t kValueSize = sizeof(T);
     JSTD_ASSERT(end >= src);
@@ -932,9 +1384,12 @@ template <typename T, std::size_t N,
                       bool destIsAligned,
                       std::size_t estimatedSize = sizeof(T)>
 JSTD_FORCED_INLINE
-void avx_move_forward_N_impl(char * JSTD_RESTRICT dest, char * JSTD_RESTRICT src,
-                             char * JSTD_RESTRICT limit, char * JSTD_RESTRICT end)
+void avx_move_forward_N_impl(char * dest, char * src,
+                             char * limit, char * end)
 {
+    const std::size_t prefetch_offset = get_rotate_params().prefetch_offset;
+    const int prefetch_hint = get_rotate_params().prefetch_hint;
+
     static const std::size_t kSingleLoopBytes = N * kAVXRegBytes;
 
     if (srcIsAligned && destIsAligned) {
@@ -965,13 +1420,13 @@ void avx_move_forward_N_impl(char * JSTD_RESTRICT dest, char * JSTD_RESTRICT src
 
             if (kUsePrefetchHint) {
                 // Here, N would be best a multiple of 2.
-                _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 0), kPrefetchHintLevel);
+                prefetch((const char *)(src + prefetch_offset + 64 * 0), prefetch_hint);
                 if (N >= 3)
-                _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 1), kPrefetchHintLevel);
+                prefetch((const char *)(src + prefetch_offset + 64 * 1), prefetch_hint);
                 if (N >= 5)
-                _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 2), kPrefetchHintLevel);
+                prefetch((const char *)(src + prefetch_offset + 64 * 2), prefetch_hint);
                 if (N >= 7)
-                _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 3), kPrefetchHintLevel);
+                prefetch((const char *)(src + prefetch_offset + 64 * 3), prefetch_hint);
             }
 
             src += kSingleLoopBytes;
@@ -1031,13 +1486,13 @@ void avx_move_forward_N_impl(char * JSTD_RESTRICT dest, char * JSTD_RESTRICT src
             //
             if (kUsePrefetchHint) {
                 // Here, N would be best a multiple of 2.
-                _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 0), kPrefetchHintLevel);
+                prefetch((const char *)(src + prefetch_offset + 64 * 0), prefetch_hint);
                 if (N >= 3)
-                _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 1), kPrefetchHintLevel);
+                prefetch((const char *)(src + prefetch_offset + 64 * 1), prefetch_hint);
                 if (N >= 5)
-                _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 2), kPrefetchHintLevel);
+                prefetch((const char *)(src + prefetch_offset + 64 * 2), prefetch_hint);
                 if (N >= 7)
-                _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 3), kPrefetchHintLevel);
+                prefetch((const char *)(src + prefetch_offset + 64 * 3), prefetch_hint);
             }
 
             src += kSingleLoopBytes;
@@ -1094,13 +1549,13 @@ void avx_move_forward_N_impl(char * JSTD_RESTRICT dest, char * JSTD_RESTRICT src
 
             if (kUsePrefetchHint) {
                 // Here, N would be best a multiple of 2.
-                _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 0), kPrefetchHintLevel);
+                prefetch((const char *)(src + prefetch_offset + 64 * 0), prefetch_hint);
                 if (N >= 3)
-                _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 1), kPrefetchHintLevel);
+                prefetch((const char *)(src + prefetch_offset + 64 * 1), prefetch_hint);
                 if (N >= 5)
-                _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 2), kPrefetchHintLevel);
+                prefetch((const char *)(src + prefetch_offset + 64 * 2), prefetch_hint);
                 if (N >= 7)
-                _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 3), kPrefetchHintLevel);
+                prefetch((const char *)(src + prefetch_offset + 64 * 3), prefetch_hint);
             }
 
             src += kSingleLoopBytes;
@@ -1157,13 +1612,13 @@ void avx_move_forward_N_impl(char * JSTD_RESTRICT dest, char * JSTD_RESTRICT src
 
             if (kUsePrefetchHint) {
                 // Here, N would be best a multiple of 2.
-                _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 0), kPrefetchHintLevel);
+                prefetch((const char *)(src + prefetch_offset + 64 * 0), prefetch_hint);
                 if (N >= 3)
-                _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 1), kPrefetchHintLevel);
+                prefetch((const char *)(src + prefetch_offset + 64 * 1), prefetch_hint);
                 if (N >= 5)
-                _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 2), kPrefetchHintLevel);
+                prefetch((const char *)(src + prefetch_offset + 64 * 2), prefetch_hint);
                 if (N >= 7)
-                _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 3), kPrefetchHintLevel);
+                prefetch((const char *)(src + prefetch_offset + 64 * 3), prefetch_hint);
             }
 
             src += kSingleLoopBytes;
@@ -1200,8 +1655,11 @@ void avx_move_forward_N_impl(char * JSTD_RESTRICT dest, char * JSTD_RESTRICT src
 template <typename T, std::size_t N = 8>
 static
 JSTD_NO_INLINE
-void avx_move_forward_N_load_aligned(T * JSTD_RESTRICT first, T * JSTD_RESTRICT mid, T * JSTD_RESTRICT last)
+void avx_move_forward_N_load_aligned(T * first, T * mid, T * last)
 {
+    const std::size_t prefetch_offset = get_rotate_params().prefetch_offset;
+    const int prefetch_hint = get_rotate_params().prefetch_hint;
+
     static const std::size_t kValueSize = sizeof(T);
     static const bool kValueSizeIsPower2 = ((kValueSize & (kValueSize - 1)) == 0);
     static const bool kValueSizeIsDivisible =  (kValueSize < kAVXRegBytes) ?
@@ -1225,13 +1683,13 @@ void avx_move_forward_N_load_aligned(T * JSTD_RESTRICT first, T * JSTD_RESTRICT
             srcPaddingBytes -= kValueSize;
         }
 
-        char * JSTD_RESTRICT dest = (char * JSTD_RESTRICT)first;
-        char * JSTD_RESTRICT src = (char * JSTD_RESTRICT)mid;
-        char * JSTD_RESTRICT end = (char * JSTD_RESTRICT)last;
+        char * dest = (char *)first;
+        char * src = (char *)mid;
+        char * end = (char *)last;
 
         std::size_t totalMoveBytes = (last - mid) * kValueSize;
         std::size_t unalignedMoveBytes = (std::size_t)totalMoveBytes % kSingleLoopBytes;
-        const char * JSTD_RESTRICT limit = (totalMoveBytes >= kSingleLoopBytes) ? (end - unalignedMoveBytes) : src;
+        const char * limit = (totalMoveBytes >= kSingleLoopBytes) ? (end - unalignedMoveBytes) : src;
 
         bool destAddrIsAligned = (((std::size_t)dest & kAVXAlignMask) == 0);
         if (likely(!destAddrIsAligned)) {
@@ -1264,13 +1722,13 @@ void avx_move_forward_N_load_aligned(T * JSTD_RESTRICT first, T * JSTD_RESTRICT
                 //
                 if (kUsePrefetchHint) {
                     // Here, N would be best a multiple of 2.
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 0), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 0), prefetch_hint);
                     if (N >= 3)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 1), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 1), prefetch_hint);
                     if (N >= 5)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 2), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 2), prefetch_hint);
                     if (N >= 7)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 3), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 3), prefetch_hint);
                 }
 
                 src += kSingleLoopBytes;
@@ -1325,13 +1783,13 @@ void avx_move_forward_N_load_aligned(T * JSTD_RESTRICT first, T * JSTD_RESTRICT
 
                 if (kUsePrefetchHint) {
                     // Here, N would be best a multiple of 2.
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 0), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 0), prefetch_hint);
                     if (N >= 3)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 1), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 1), prefetch_hint);
                     if (N >= 5)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 2), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 2), prefetch_hint);
                     if (N >= 7)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 3), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 3), prefetch_hint);
                 }
 
                 src += kSingleLoopBytes;
@@ -1379,13 +1837,13 @@ void avx_move_forward_N_load_aligned(T * JSTD_RESTRICT first, T * JSTD_RESTRICT
             }
         }
 
-        char * JSTD_RESTRICT dest = (char * JSTD_RESTRICT)first;
-        char * JSTD_RESTRICT src = (char * JSTD_RESTRICT)mid;
-        char * JSTD_RESTRICT end = (char * JSTD_RESTRICT)last;
+        char * dest = (char *)first;
+        char * src = (char *)mid;
+        char * end = (char *)last;
 
         std::size_t totalMoveBytes = (last - mid) * kValueSize;
         std::size_t unalignedMoveBytes = (std::size_t)totalMoveBytes % kSingleLoopBytes;
-        const char * JSTD_RESTRICT limit = (totalMoveBytes >= kSingleLoopBytes) ? (end - unalignedMoveBytes) : src;
+        const char * limit = (totalMoveBytes >= kSingleLoopBytes) ? (end - unalignedMoveBytes) : src;
 
         if (likely(destAddrIsAligned)) {
 #if defined(JSTD_IS_ICC)
@@ -1414,13 +1872,13 @@ void avx_move_forward_N_load_aligned(T * JSTD_RESTRICT first, T * JSTD_RESTRICT
 
                 if (kUsePrefetchHint) {
                     // Here, N would be best a multiple of 2.
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 0), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 0), prefetch_hint);
                     if (N >= 3)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 1), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 1), prefetch_hint);
                     if (N >= 5)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 2), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 2), prefetch_hint);
                     if (N >= 7)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 3), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 3), prefetch_hint);
                 }
 
                 src += kSingleLoopBytes;
@@ -1475,13 +1933,13 @@ void avx_move_forward_N_load_aligned(T * JSTD_RESTRICT first, T * JSTD_RESTRICT
 
                 if (kUsePrefetchHint) {
                     // Here, N would be best a multiple of 2.
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 0), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 0), prefetch_hint);
                     if (N >= 3)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 1), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 1), prefetch_hint);
                     if (N >= 5)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 2), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 2), prefetch_hint);
                     if (N >= 7)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 3), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 3), prefetch_hint);
                 }
 
                 src += kSingleLoopBytes;
@@ -1516,8 +1974,11 @@ void avx_move_forward_N_load_aligned(T * JSTD_RESTRICT first, T * JSTD_RESTRICT
 template <typename T, std::size_t N = 8, std::size_t estimatedSize = sizeof(T)>
 static
 JSTD_NO_INLINE
-void avx_move_forward_N_store_aligned(T * JSTD_RESTRICT first, T * JSTD_RESTRICT mid, T * JSTD_RESTRICT last)
+void avx_move_forward_N_store_aligned(T * first, T * mid, T * last)
 {
+    const std::size_t prefetch_offset = get_rotate_params().prefetch_offset;
+    const int prefetch_hint = get_rotate_params().prefetch_hint;
+
     static const std::size_t kValueSize = sizeof(T);
     static const bool kValueSizeIsPower2 = ((kValueSize & (kValueSize - 1)) == 0);
     static const bool kValueSizeIsDivisible =  (kValueSize < kAVXRegBytes) ?
@@ -1541,13 +2002,13 @@ void avx_move_forward_N_store_aligned(T * JSTD_RESTRICT first, T * JSTD_RESTRICT
             destPaddingBytes -= kValueSize;
         }
 
-        char * JSTD_RESTRICT dest = (char * JSTD_RESTRICT)first;
-        char * JSTD_RESTRICT src = (char * JSTD_RESTRICT)mid;
-        char * JSTD_RESTRICT end = (char * JSTD_RESTRICT)last;
+        char * dest = (char *)first;
+        char * src = (char *)mid;
+        char * end = (char *)last;
 
         std::size_t totalMoveBytes = (last - mid) * kValueSize;
         std::size_t unalignedMoveBytes = (std::size_t)totalMoveBytes % kSingleLoopBytes;
-        const char * JSTD_RESTRICT limit = (totalMoveBytes >= kSingleLoopBytes) ? (end - unalignedMoveBytes) : src;
+        const char * limit = (totalMoveBytes >= kSingleLoopBytes) ? (end - unalignedMoveBytes) : src;
 
         bool srcAddrIsAligned = (((std::size_t)src & kAVXAlignMask) == 0);
         if (likely(!srcAddrIsAligned)) {
@@ -1595,13 +2056,13 @@ void avx_move_forward_N_store_aligned(T * JSTD_RESTRICT first, T * JSTD_RESTRICT
                 //
                 if (kUsePrefetchHint) {
                     // Here, N would be best a multiple of 2.
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 0), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 0), prefetch_hint);
                     if (N >= 3)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 1), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 1), prefetch_hint);
                     if (N >= 5)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 2), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 2), prefetch_hint);
                     if (N >= 7)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 3), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 3), prefetch_hint);
                 }
 
                 src += kSingleLoopBytes;
@@ -1686,13 +2147,13 @@ void avx_move_forward_N_store_aligned(T * JSTD_RESTRICT first, T * JSTD_RESTRICT
 
                 if (kUsePrefetchHint) {
                     // Here, N would be best a multiple of 2.
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 0), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 0), prefetch_hint);
                     if (N >= 3)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 1), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 1), prefetch_hint);
                     if (N >= 5)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 2), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 2), prefetch_hint);
                     if (N >= 7)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 3), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 3), prefetch_hint);
                 }
 
                 src += kSingleLoopBytes;
@@ -1755,13 +2216,13 @@ void avx_move_forward_N_store_aligned(T * JSTD_RESTRICT first, T * JSTD_RESTRICT
             }
         }
 
-        char * JSTD_RESTRICT dest = (char * JSTD_RESTRICT)first;
-        char * JSTD_RESTRICT src = (char * JSTD_RESTRICT)mid;
-        char * JSTD_RESTRICT end = (char * JSTD_RESTRICT)last;
+        char * dest = (char *)first;
+        char * src = (char *)mid;
+        char * end = (char *)last;
 
         std::size_t totalMoveBytes = (last - mid) * kValueSize;
         std::size_t unalignedMoveBytes = (std::size_t)totalMoveBytes % kSingleLoopBytes;
-        const char * JSTD_RESTRICT limit = (totalMoveBytes >= kSingleLoopBytes) ? (end - unalignedMoveBytes) : src;
+        const char * limit = (totalMoveBytes >= kSingleLoopBytes) ? (end - unalignedMoveBytes) : src;
 
         if (likely(srcAddrIsAligned)) {
 #if defined(JSTD_IS_ICC)
@@ -1805,13 +2266,13 @@ void avx_move_forward_N_store_aligned(T * JSTD_RESTRICT first, T * JSTD_RESTRICT
 
                 if (kUsePrefetchHint) {
                     // Here, N would be best a multiple of 2.
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 0), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 0), prefetch_hint);
                     if (N >= 3)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 1), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 1), prefetch_hint);
                     if (N >= 5)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 2), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 2), prefetch_hint);
                     if (N >= 7)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 3), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 3), prefetch_hint);
                 }
 
                 src += kSingleLoopBytes;
@@ -1896,13 +2357,13 @@ void avx_move_forward_N_store_aligned(T * JSTD_RESTRICT first, T * JSTD_RESTRICT
 
                 if (kUsePrefetchHint) {
                     // Here, N would be best a multiple of 2.
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 0), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 0), prefetch_hint);
                     if (N >= 3)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 1), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 1), prefetch_hint);
                     if (N >= 5)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 2), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 2), prefetch_hint);
                     if (N >= 7)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 3), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 3), prefetch_hint);
                 }
 
                 src += kSingleLoopBytes;
@@ -1952,8 +2413,11 @@ void avx_move_forward_N_store_aligned(T * JSTD_RESTRICT first, T * JSTD_RESTRICT
 template <typename T, std::size_t N = 8>
 static
 JSTD_NO_INLINE
-void avx_move_forward_N_store_aligned_nt(T * JSTD_RESTRICT first, T * JSTD_RESTRICT mid, T * JSTD_RESTRICT last)
+void avx_move_forward_N_store_aligned_nt(T * first, T * mid, T * last)
 {
+    const std::size_t prefetch_offset = get_rotate_params().prefetch_offset;
+    const int prefetch_hint = get_rotate_params().prefetch_hint;
+
     static const std::size_t kValueSize = sizeof(T);
     static const bool kValueSizeIsPower2 = ((kValueSize & (kValueSize - 1)) == 0);
     static const bool kValueSizeIsDivisible =  (kValueSize < kAVXRegBytes) ?
@@ -1977,13 +2441,13 @@ void avx_move_forward_N_store_aligned_nt(T * JSTD_RESTRICT first, T * JSTD_RESTR
             destPaddingBytes -= kValueSize;
         }
 
-        char * JSTD_RESTRICT dest = (char * JSTD_RESTRICT)first;
-        char * JSTD_RESTRICT src = (char * JSTD_RESTRICT)mid;
-        char * JSTD_RESTRICT end = (char * JSTD_RESTRICT)last;
+        char * dest = (char *)first;
+        char * src = (char *)mid;
+        char * end = (char *)last;
 
         std::size_t totalMoveBytes = (last - mid) * kValueSize;
         std::size_t unalignedMoveBytes = (std::size_t)totalMoveBytes % kSingleLoopBytes;
-        const char * JSTD_RESTRICT limit = (totalMoveBytes >= kSingleLoopBytes) ? (end - unalignedMoveBytes) : src;
+        const char * limit = (totalMoveBytes >= kSingleLoopBytes) ? (end - unalignedMoveBytes) : src;
 
         bool srcAddrIsAligned = (((std::size_t)src & kAVXAlignMask) == 0);
         if (likely(!srcAddrIsAligned)) {
@@ -2013,13 +2477,13 @@ void avx_move_forward_N_store_aligned_nt(T * JSTD_RESTRICT first, T * JSTD_RESTR
                 //
                 if (kUsePrefetchHint) {
                     // Here, N would be best a multiple of 2.
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 0), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 0), prefetch_hint);
                     if (N >= 3)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 1), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 1), prefetch_hint);
                     if (N >= 5)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 2), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 2), prefetch_hint);
                     if (N >= 7)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 3), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 3), prefetch_hint);
                 }
 
                 src += kSingleLoopBytes;
@@ -2071,13 +2535,13 @@ void avx_move_forward_N_store_aligned_nt(T * JSTD_RESTRICT first, T * JSTD_RESTR
 
                 if (kUsePrefetchHint) {
                     // Here, N would be best a multiple of 2.
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 0), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 0), prefetch_hint);
                     if (N >= 3)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 1), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 1), prefetch_hint);
                     if (N >= 5)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 2), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 2), prefetch_hint);
                     if (N >= 7)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 3), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 3), prefetch_hint);
                 }
 
                 src += kSingleLoopBytes;
@@ -2127,13 +2591,13 @@ void avx_move_forward_N_store_aligned_nt(T * JSTD_RESTRICT first, T * JSTD_RESTR
             }
         }
 
-        char * JSTD_RESTRICT dest = (char * JSTD_RESTRICT)first;
-        char * JSTD_RESTRICT src = (char * JSTD_RESTRICT)mid;
-        char * JSTD_RESTRICT end = (char * JSTD_RESTRICT)last;
+        char * dest = (char *)first;
+        char * src = (char *)mid;
+        char * end = (char *)last;
 
         std::size_t totalMoveBytes = (last - mid) * kValueSize;
         std::size_t unalignedMoveBytes = (std::size_t)totalMoveBytes % kSingleLoopBytes;
-        const char * JSTD_RESTRICT limit = (totalMoveBytes >= kSingleLoopBytes) ? (end - unalignedMoveBytes) : src;
+        const char * limit = (totalMoveBytes >= kSingleLoopBytes) ? (end - unalignedMoveBytes) : src;
 
         if (likely(srcAddrIsAligned)) {
             while (src < limit) {
@@ -2159,13 +2623,13 @@ void avx_move_forward_N_store_aligned_nt(T * JSTD_RESTRICT first, T * JSTD_RESTR
 
                 if (kUsePrefetchHint) {
                     // Here, N would be best a multiple of 2.
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 0), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 0), prefetch_hint);
                     if (N >= 3)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 1), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 1), prefetch_hint);
                     if (N >= 5)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 2), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 2), prefetch_hint);
                     if (N >= 7)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 3), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 3), prefetch_hint);
                 }
 
                 src += kSingleLoopBytes;
@@ -2217,13 +2681,13 @@ void avx_move_forward_N_store_aligned_nt(T * JSTD_RESTRICT first, T * JSTD_RESTR
 
                 if (kUsePrefetchHint) {
                     // Here, N would be best a multiple of 2.
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 0), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 0), prefetch_hint);
                     if (N >= 3)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 1), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 1), prefetch_hint);
                     if (N >= 5)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 2), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 2), prefetch_hint);
                     if (N >= 7)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 3), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 3), prefetch_hint);
                 }
 
                 src += kSingleLoopBytes;
@@ -2258,8 +2722,11 @@ void avx_move_forward_N_store_aligned_nt(T * JSTD_RESTRICT first, T * JSTD_RESTR
 template <typename T, std::size_t N = 8>
 static
 JSTD_NO_INLINE
-void avx_move_forward_Nx2_load_aligned(T * JSTD_RESTRICT first, T * JSTD_RESTRICT mid, T * JSTD_RESTRICT last)
+void avx_move_forward_Nx2_load_aligned(T * first, T * mid, T * last)
 {
+    const std::size_t prefetch_offset = get_rotate_params().prefetch_offset;
+    const int prefetch_hint = get_rotate_params().prefetch_hint;
+
     static const std::size_t kValueSize = sizeof(T);
     static const bool kValueSizeIsPower2 = ((kValueSize & (kValueSize - 1)) == 0);
     static const bool kValueSizeIsDivisible =  (kValueSize < kAVXRegBytes) ?
@@ -2284,13 +2751,13 @@ void avx_move_forward_Nx2_load_aligned(T * JSTD_RESTRICT first, T * JSTD_RESTRIC
             srcPaddingBytes -= kValueSize;
         }
 
-        char * JSTD_RESTRICT dest = (char * JSTD_RESTRICT)first;
-        char * JSTD_RESTRICT src = (char * JSTD_RESTRICT)mid;
-        char * JSTD_RESTRICT end = (char * JSTD_RESTRICT)last;
+        char * dest = (char *)first;
+        char * src = (char *)mid;
+        char * end = (char *)last;
 
         std::size_t totalMoveBytes = (last - mid) * kValueSize;
         std::size_t unalignedMoveBytes = (std::size_t)totalMoveBytes % kSingleLoopBytes;
-        const char * JSTD_RESTRICT limit = (totalMoveBytes >= kSingleLoopBytes) ? (end - unalignedMoveBytes) : src;
+        const char * limit = (totalMoveBytes >= kSingleLoopBytes) ? (end - unalignedMoveBytes) : src;
 
         bool destAddrIsAligned = (((std::size_t)dest & kAVXAlignMask) == 0);
         if (likely(!destAddrIsAligned)) {
@@ -2323,13 +2790,13 @@ void avx_move_forward_Nx2_load_aligned(T * JSTD_RESTRICT first, T * JSTD_RESTRIC
                 //
                 if (kUsePrefetchHint) {
                     // Here, N would be best a multiple of 2.
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 0), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 0), prefetch_hint);
                     if (N >= 3)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 1), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 1), prefetch_hint);
                     if (N >= 5)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 2), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 2), prefetch_hint);
                     if (N >= 7)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 3), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 3), prefetch_hint);
                 }
 
                 src += kHalfLoopBytes;
@@ -2381,13 +2848,13 @@ void avx_move_forward_Nx2_load_aligned(T * JSTD_RESTRICT first, T * JSTD_RESTRIC
                 //
                 if (kUsePrefetchHint) {
                     // Here, N would be best a multiple of 2.
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 0), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 0), prefetch_hint);
                     if (N >= 3)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 1), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 1), prefetch_hint);
                     if (N >= 5)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 2), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 2), prefetch_hint);
                     if (N >= 7)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 3), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 3), prefetch_hint);
                 }
 
                 src += kHalfLoopBytes;
@@ -2443,13 +2910,13 @@ void avx_move_forward_Nx2_load_aligned(T * JSTD_RESTRICT first, T * JSTD_RESTRIC
 
                 if (kUsePrefetchHint) {
                     // Here, N would be best a multiple of 2.
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 0), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 0), prefetch_hint);
                     if (N >= 3)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 1), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 1), prefetch_hint);
                     if (N >= 5)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 2), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 2), prefetch_hint);
                     if (N >= 7)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 3), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 3), prefetch_hint);
                 }
 
                 src += kHalfLoopBytes;
@@ -2498,13 +2965,13 @@ void avx_move_forward_Nx2_load_aligned(T * JSTD_RESTRICT first, T * JSTD_RESTRIC
 
                 if (kUsePrefetchHint) {
                     // Here, N would be best a multiple of 2.
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 0), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 0), prefetch_hint);
                     if (N >= 3)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 1), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 1), prefetch_hint);
                     if (N >= 5)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 2), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 2), prefetch_hint);
                     if (N >= 7)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 3), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 3), prefetch_hint);
                 }
 
                 src += kHalfLoopBytes;
@@ -2552,13 +3019,13 @@ void avx_move_forward_Nx2_load_aligned(T * JSTD_RESTRICT first, T * JSTD_RESTRIC
             }
         }
 
-        char * JSTD_RESTRICT dest = (char * JSTD_RESTRICT)first;
-        char * JSTD_RESTRICT src = (char * JSTD_RESTRICT)mid;
-        char * JSTD_RESTRICT end = (char * JSTD_RESTRICT)last;
+        char * dest = (char *)first;
+        char * src = (char *)mid;
+        char * end = (char *)last;
 
         std::size_t totalMoveBytes = (last - mid) * kValueSize;
         std::size_t unalignedMoveBytes = (std::size_t)totalMoveBytes % kSingleLoopBytes;
-        const char * JSTD_RESTRICT limit = (totalMoveBytes >= kSingleLoopBytes) ? (end - unalignedMoveBytes) : src;
+        const char * limit = (totalMoveBytes >= kSingleLoopBytes) ? (end - unalignedMoveBytes) : src;
 
         if (likely(destAddrIsAligned)) {
 #if defined(JSTD_IS_ICC)
@@ -2587,13 +3054,13 @@ void avx_move_forward_Nx2_load_aligned(T * JSTD_RESTRICT first, T * JSTD_RESTRIC
 
                 if (kUsePrefetchHint) {
                     // Here, N would be best a multiple of 2.
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 0), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 0), prefetch_hint);
                     if (N >= 3)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 1), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 1), prefetch_hint);
                     if (N >= 5)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 2), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 2), prefetch_hint);
                     if (N >= 7)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 3), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 3), prefetch_hint);
                 }
 
                 src += kHalfLoopBytes;
@@ -2642,13 +3109,13 @@ void avx_move_forward_Nx2_load_aligned(T * JSTD_RESTRICT first, T * JSTD_RESTRIC
 
                 if (kUsePrefetchHint) {
                     // Here, N would be best a multiple of 2.
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 0), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 0), prefetch_hint);
                     if (N >= 3)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 1), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 1), prefetch_hint);
                     if (N >= 5)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 2), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 2), prefetch_hint);
                     if (N >= 7)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 3), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 3), prefetch_hint);
                 }
 
                 src += kHalfLoopBytes;
@@ -2704,13 +3171,13 @@ void avx_move_forward_Nx2_load_aligned(T * JSTD_RESTRICT first, T * JSTD_RESTRIC
 
                 if (kUsePrefetchHint) {
                     // Here, N would be best a multiple of 2.
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 0), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 0), prefetch_hint);
                     if (N >= 3)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 1), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 1), prefetch_hint);
                     if (N >= 5)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 2), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 2), prefetch_hint);
                     if (N >= 7)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 3), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 3), prefetch_hint);
                 }
 
                 src += kHalfLoopBytes;
@@ -2759,13 +3226,13 @@ void avx_move_forward_Nx2_load_aligned(T * JSTD_RESTRICT first, T * JSTD_RESTRIC
 
                 if (kUsePrefetchHint) {
                     // Here, N would be best a multiple of 2.
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 0), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 0), prefetch_hint);
                     if (N >= 3)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 1), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 1), prefetch_hint);
                     if (N >= 5)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 2), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 2), prefetch_hint);
                     if (N >= 7)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 3), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 3), prefetch_hint);
                 }
 
                 src += kHalfLoopBytes;
@@ -2800,8 +3267,11 @@ void avx_move_forward_Nx2_load_aligned(T * JSTD_RESTRICT first, T * JSTD_RESTRIC
 template <typename T, std::size_t N = 8>
 static
 JSTD_NO_INLINE
-void avx_move_forward_Nx2_store_aligned(T * JSTD_RESTRICT first, T * JSTD_RESTRICT mid, T * JSTD_RESTRICT last)
+void avx_move_forward_Nx2_store_aligned(T * first, T * mid, T * last)
 {
+    const std::size_t prefetch_offset = get_rotate_params().prefetch_offset;
+    const int prefetch_hint = get_rotate_params().prefetch_hint;
+
     static const std::size_t kValueSize = sizeof(T);
     static const bool kValueSizeIsPower2 = ((kValueSize & (kValueSize - 1)) == 0);
     static const bool kValueSizeIsDivisible =  (kValueSize < kAVXRegBytes) ?
@@ -2826,13 +3296,13 @@ void avx_move_forward_Nx2_store_aligned(T * JSTD_RESTRICT first, T * JSTD_RESTRI
             destPaddingBytes -= kValueSize;
         }
 
-        char * JSTD_RESTRICT dest = (char * JSTD_RESTRICT)first;
-        char * JSTD_RESTRICT src = (char * JSTD_RESTRICT)mid;
-        char * JSTD_RESTRICT end = (char * JSTD_RESTRICT)last;
+        char * dest = (char *)first;
+        char * src = (char *)mid;
+        char * end = (char *)last;
 
         std::size_t totalMoveBytes = (last - mid) * kValueSize;
         std::size_t unalignedMoveBytes = (std::size_t)totalMoveBytes % kSingleLoopBytes;
-        const char * JSTD_RESTRICT limit = (totalMoveBytes >= kSingleLoopBytes) ? (end - unalignedMoveBytes) : src;
+        const char * limit = (totalMoveBytes >= kSingleLoopBytes) ? (end - unalignedMoveBytes) : src;
 
         bool srcAddrIsAligned = (((std::size_t)src & kAVXAlignMask) == 0);
         if (likely(!srcAddrIsAligned)) {
@@ -2865,13 +3335,13 @@ void avx_move_forward_Nx2_store_aligned(T * JSTD_RESTRICT first, T * JSTD_RESTRI
                 //
                 if (kUsePrefetchHint) {
                     // Here, N would be best a multiple of 2.
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 0), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 0), prefetch_hint);
                     if (N >= 3)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 1), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 1), prefetch_hint);
                     if (N >= 5)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 2), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 2), prefetch_hint);
                     if (N >= 7)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 3), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 3), prefetch_hint);
                 }
 
                 src += kHalfLoopBytes;
@@ -2920,13 +3390,13 @@ void avx_move_forward_Nx2_store_aligned(T * JSTD_RESTRICT first, T * JSTD_RESTRI
 
                 if (kUsePrefetchHint) {
                     // Here, N would be best a multiple of 2.
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 0), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 0), prefetch_hint);
                     if (N >= 3)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 1), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 1), prefetch_hint);
                     if (N >= 5)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 2), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 2), prefetch_hint);
                     if (N >= 7)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 3), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 3), prefetch_hint);
                 }
 
                 src += kHalfLoopBytes;
@@ -2982,13 +3452,13 @@ void avx_move_forward_Nx2_store_aligned(T * JSTD_RESTRICT first, T * JSTD_RESTRI
 
                 if (kUsePrefetchHint) {
                     // Here, N would be best a multiple of 2.
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 0), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 0), prefetch_hint);
                     if (N >= 3)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 1), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 1), prefetch_hint);
                     if (N >= 5)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 2), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 2), prefetch_hint);
                     if (N >= 7)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 3), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 3), prefetch_hint);
                 }
 
                 src += kHalfLoopBytes;
@@ -3037,13 +3507,13 @@ void avx_move_forward_Nx2_store_aligned(T * JSTD_RESTRICT first, T * JSTD_RESTRI
 
                 if (kUsePrefetchHint) {
                     // Here, N would be best a multiple of 2.
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 0), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 0), prefetch_hint);
                     if (N >= 3)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 1), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 1), prefetch_hint);
                     if (N >= 5)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 2), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 2), prefetch_hint);
                     if (N >= 7)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 3), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 3), prefetch_hint);
                 }
 
                 src += kHalfLoopBytes;
@@ -3091,13 +3561,13 @@ void avx_move_forward_Nx2_store_aligned(T * JSTD_RESTRICT first, T * JSTD_RESTRI
             }
         }
 
-        char * JSTD_RESTRICT dest = (char * JSTD_RESTRICT)first;
-        char * JSTD_RESTRICT src = (char * JSTD_RESTRICT)mid;
-        char * JSTD_RESTRICT end = (char * JSTD_RESTRICT)last;
+        char * dest = (char *)first;
+        char * src = (char *)mid;
+        char * end = (char *)last;
 
         std::size_t totalMoveBytes = (last - mid) * kValueSize;
         std::size_t unalignedMoveBytes = (std::size_t)totalMoveBytes % kSingleLoopBytes;
-        const char * JSTD_RESTRICT limit = (totalMoveBytes >= kSingleLoopBytes) ? (end - unalignedMoveBytes) : src;
+        const char * limit = (totalMoveBytes >= kSingleLoopBytes) ? (end - unalignedMoveBytes) : src;
 
         if (likely(srcAddrIsAligned)) {
 #if defined(JSTD_IS_ICC)
@@ -3126,13 +3596,13 @@ void avx_move_forward_Nx2_store_aligned(T * JSTD_RESTRICT first, T * JSTD_RESTRI
 
                 if (kUsePrefetchHint) {
                     // Here, N would be best a multiple of 2.
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 0), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 0), prefetch_hint);
                     if (N >= 3)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 1), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 1), prefetch_hint);
                     if (N >= 5)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 2), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 2), prefetch_hint);
                     if (N >= 7)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 3), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 3), prefetch_hint);
                 }
 
                 src += kHalfLoopBytes;
@@ -3181,13 +3651,13 @@ void avx_move_forward_Nx2_store_aligned(T * JSTD_RESTRICT first, T * JSTD_RESTRI
 
                 if (kUsePrefetchHint) {
                     // Here, N would be best a multiple of 2.
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 0), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 0), prefetch_hint);
                     if (N >= 3)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 1), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 1), prefetch_hint);
                     if (N >= 5)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 2), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 2), prefetch_hint);
                     if (N >= 7)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 3), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 3), prefetch_hint);
                 }
 
                 src += kHalfLoopBytes;
@@ -3243,13 +3713,13 @@ void avx_move_forward_Nx2_store_aligned(T * JSTD_RESTRICT first, T * JSTD_RESTRI
 
                 if (kUsePrefetchHint) {
                     // Here, N would be best a multiple of 2.
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 0), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 0), prefetch_hint);
                     if (N >= 3)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 1), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 1), prefetch_hint);
                     if (N >= 5)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 2), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 2), prefetch_hint);
                     if (N >= 7)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 3), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 3), prefetch_hint);
                 }
 
                 src += kHalfLoopBytes;
@@ -3298,13 +3768,13 @@ void avx_move_forward_Nx2_store_aligned(T * JSTD_RESTRICT first, T * JSTD_RESTRI
 
                 if (kUsePrefetchHint) {
                     // Here, N would be best a multiple of 2.
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 0), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 0), prefetch_hint);
                     if (N >= 3)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 1), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 1), prefetch_hint);
                     if (N >= 5)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 2), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 2), prefetch_hint);
                     if (N >= 7)
-                    _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 3), kPrefetchHintLevel);
+                    prefetch((const char *)(src + prefetch_offset + 64 * 3), prefetch_hint);
                 }
 
                 src += kHalfLoopBytes;
@@ -3344,6 +3814,9 @@ JSTD_FORCED_INLINE
 void avx_mem_copy_N_impl(char * JSTD_RESTRICT dest, char * JSTD_RESTRICT src,
                          char * JSTD_RESTRICT limit, char * JSTD_RESTRICT end)
 {
+    const std::size_t prefetch_offset = get_rotate_params().prefetch_offset;
+    const int prefetch_hint = get_rotate_params().prefetch_hint;
+
     static const std::size_t kSingleLoopBytes = N * kAVXRegBytes;
 
     if (srcIsAligned && destIsAligned) {
@@ -3374,13 +3847,13 @@ void avx_mem_copy_N_impl(char * JSTD_RESTRICT dest, char * JSTD_RESTRICT src,
 
             if (kUsePrefetchHint) {
                 // Here, N would be best a multiple of 2.
-                _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 0), kPrefetchHintLevel);
+                prefetch((const char *)(src + prefetch_offset + 64 * 0), prefetch_hint);
                 if (N >= 3)
-                _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 1), kPrefetchHintLevel);
+                prefetch((const char *)(src + prefetch_offset + 64 * 1), prefetch_hint);
                 if (N >= 5)
-                _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 2), kPrefetchHintLevel);
+                prefetch((const char *)(src + prefetch_offset + 64 * 2), prefetch_hint);
                 if (N >= 7)
-                _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 3), kPrefetchHintLevel);
+                prefetch((const char *)(src + prefetch_offset + 64 * 3), prefetch_hint);
             }
 
             src += kSingleLoopBytes;
@@ -3440,13 +3913,13 @@ void avx_mem_copy_N_impl(char * JSTD_RESTRICT dest, char * JSTD_RESTRICT src,
             //
             if (kUsePrefetchHint) {
                 // Here, N would be best a multiple of 2.
-                _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 0), kPrefetchHintLevel);
+                prefetch((const char *)(src + prefetch_offset + 64 * 0), prefetch_hint);
                 if (N >= 3)
-                _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 1), kPrefetchHintLevel);
+                prefetch((const char *)(src + prefetch_offset + 64 * 1), prefetch_hint);
                 if (N >= 5)
-                _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 2), kPrefetchHintLevel);
+                prefetch((const char *)(src + prefetch_offset + 64 * 2), prefetch_hint);
                 if (N >= 7)
-                _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 3), kPrefetchHintLevel);
+                prefetch((const char *)(src + prefetch_offset + 64 * 3), prefetch_hint);
             }
 
             src += kSingleLoopBytes;
@@ -3503,13 +3976,13 @@ void avx_mem_copy_N_impl(char * JSTD_RESTRICT dest, char * JSTD_RESTRICT src,
 
             if (kUsePrefetchHint) {
                 // Here, N would be best a multiple of 2.
-                _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 0), kPrefetchHintLevel);
+                prefetch((const char *)(src + prefetch_offset + 64 * 0), prefetch_hint);
                 if (N >= 3)
-                _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 1), kPrefetchHintLevel);
+                prefetch((const char *)(src + prefetch_offset + 64 * 1), prefetch_hint);
                 if (N >= 5)
-                _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 2), kPrefetchHintLevel);
+                prefetch((const char *)(src + prefetch_offset + 64 * 2), prefetch_hint);
                 if (N >= 7)
-                _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 3), kPrefetchHintLevel);
+                prefetch((const char *)(src + prefetch_offset + 64 * 3), prefetch_hint);
             }
 
             src += kSingleLoopBytes;
@@ -3566,13 +4039,13 @@ void avx_mem_copy_N_impl(char * JSTD_RESTRICT dest, char * JSTD_RESTRICT src,
 
             if (kUsePrefetchHint) {
                 // Here, N would be best a multiple of 2.
-                _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 0), kPrefetchHintLevel);
+                prefetch((const char *)(src + prefetch_offset + 64 * 0), prefetch_hint);
                 if (N >= 3)
-                _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 1), kPrefetchHintLevel);
+                prefetch((const char *)(src + prefetch_offset + 64 * 1), prefetch_hint);
                 if (N >= 5)
-                _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 2), kPrefetchHintLevel);
+                prefetch((const char *)(src + prefetch_offset + 64 * 2), prefetch_hint);
                 if (N >= 7)
-                _mm_prefetch((const char *)(src + kPrefetchOffset + 64 * 3), kPrefetchHintLevel);
+                prefetch((const char *)(src + prefetch_offset + 64 * 3), prefetch_hint);
             }
 
             src += kSingleLoopBytes;
@@ -3635,7 +4108,7 @@ void avx_mem_copy_N_store_aligned(void * JSTD_RESTRICT _dest, void * JSTD_RESTRI
         std::size_t totalCopyBytes = (end - src);
         JSTD_ASSERT((totalCopyBytes % kValueSize) == 0);
         std::size_t unalignedCopyBytes = (std::size_t)totalCopyBytes % kSingleLoopBytes;
-        const char * JSTD_RESTRICT limit = ((estimatedSize >= kSingleLoopBytes) || (totalCopyBytes >= kSingleLoopBytes))
+        char * JSTD_RESTRICT limit = ((estimatedSize >= kSingleLoopBytes) || (totalCopyBytes >= kSingleLoopBytes))
                                           ? (end - unalignedCopyBytes) : src;
 
         std::size_t srcUnalignedBytes = (std::size_t)src & kAVXAlignMask;
@@ -3670,7 +4143,7 @@ void avx_mem_copy_N_store_aligned(void * JSTD_RESTRICT _dest, void * JSTD_RESTRI
             std::size_t totalCopyBytes = (end - src);
             JSTD_ASSERT((totalCopyBytes % kValueSize) == 0);
             std::size_t unalignedCopyBytes = (std::size_t)totalCopyBytes % kSingleLoopBytes;
-            const char * JSTD_RESTRICT limit = ((estimatedSize >= kSingleLoopBytes) || (totalCopyBytes >= kSingleLoopBytes))
+            char * JSTD_RESTRICT limit = ((estimatedSize >= kSingleLoopBytes) || (totalCopyBytes >= kSingleLoopBytes))
                                               ? (end - unalignedCopyBytes) : src;
 
             std::size_t destUnalignedBytes = (std::size_t)dest & kAVXAlignMask;
@@ -3701,21 +4174,41 @@ void avx_mem_copy_N_store_aligned(void * JSTD_RESTRICT _dest, void * JSTD_RESTRI
             else
                 destAddrIsAligned = (kValueSizeIsDivisible && (destUnalignedBytes == 0));
 
-            bool destAddrIsAligned2 = true;
-            if (!srcIsAligned && destAddrIsAligned) {
-                std::size_t srcPaddingBytes = (kAVXRegBytes - destUnalignedBytes) & kAVXAlignMask;
-                JSTD_ASSERT((srcPaddingBytes % kValueSize) == 0);
-                while (srcPaddingBytes != 0) {
-                    *(T *)dest = *(T *)src;
-                    dest += kValueSize;
-                    src += kValueSize;
-                    srcPaddingBytes -= kValueSize;
+            JSTD_ASSERT(end >= src);
+            bool destAddrIsAligned2 = false;
+            if (destAddrIsAligned) {
+                // Copy the head values until dest is aligned to the AVX register.
+                std::size_t destPaddingBytes = (kAVXRegBytes - destUnalignedBytes) & kAVXAlignMask;
+                JSTD_ASSERT((destPaddingBytes % kValueSize) == 0);
+                if (destPaddingBytes <= (std::size_t)(end - src)) {
+                    while (destPaddingBytes != 0) {
+                        *(T *)dest = *(T *)src;
+                        dest += kValueSize;
+                        src += kValueSize;
+                        destPaddingBytes -= kValueSize;
+                    }
+                    destAddrIsAligned2 = true;
                 }
-
-                destAddrIsAligned2 = (((std::size_t)dest & kAVXAlignMask) == 0);
             }
 
-            if (srcIsAligned || destAddrIsAligned) {
+            std::size_t totalCopyBytes = (end - src);
+            JSTD_ASSERT((totalCopyBytes % kValueSize) == 0);
+            std::size_t unalignedCopyBytes = (std::size_t)totalCopyBytes % kSingleLoopBytes;
+            char * JSTD_RESTRICT limit = ((estimatedSize >= kSingleLoopBytes) || (totalCopyBytes >= kSingleLoopBytes))
+                                        ? (end - unalignedCopyBytes) : src;
+
+            if (destAddrIsAligned2) {
+                bool srcAddrIsAligned = (((std::size_t)src & kAVXAlignMask) == 0);
+                if (srcAddrIsAligned) {
+                    // srcIsAligned = true (Actually), destIsAligned = true (Actually)
+                    avx_mem_copy_N_impl<T, _N, kSrcIsAligned, kDestIsAligned>(dest, src, limit, end);
+                } else {
+                    // srcIsAligned = false (Actually), destIsAligned = true (Actually)
+                    avx_mem_copy_N_impl<T, _N, kSrcIsNotAligned, kDestIsAligned>(dest, src, limit, end);
+                }
+            } else {
+                // srcIsAligned = false, destIsAligned = false (Actually)
+                avx_mem_copy_N_impl<T, _N, kSrcIsNotAligned, kDestIsNotAligned>(dest, src, limit, end);
             }
         }
     }
@@ -3793,7 +4286,7 @@ void _mm_storeu_last(__m128i * addr, __m128i src, std::size_t left_len)
             break;
         case 10:
             value64_0 = (uint64_t)_mm_extract_epi64(src, 0);
-            value32_0 = (uint32_t)_mm_extract_epi16(src, 2);
+            value32_0 = (uint32_t)_mm_extract_epi16(src, 4);
             *(uint64_t *)(dest + 0) = value64_0;
             *(uint16_t *)(dest + 8) = uint16_t(value32_0 & 0xFFFFu);
             break;
@@ -4128,6 +4621,117 @@ void _mm256_storeu_last(__m256i * addr, __m256i src, std::size_t left_len)
 #endif
 }
 
+//
+// The built-in choice of the forward move kernel for N stash registers,
+// the rest of the 16 AVX registers are used by the move loop.
+//
+template <typename T, std::size_t N>
+JSTD_FORCED_INLINE
+void avx_move_forward_default(T * first, T * mid, T * last)
+{
+    static const std::size_t kEstimatedSize = (N != 0) ? ((N - 1) * kAVXRegBytes) : 0;
+
+#if defined(__clang__)
+  #if 0
+    if (N <= 6)         // 1 -- 6,
+        avx_move_forward_Nx2_load_aligned<T, 8>(first, mid, last);
+    else if (N <= 8)    // 7, 8
+        avx_move_forward_Nx2_load_aligned<T, 6>(first, mid, last);
+    else                // 9, 10, 11, 12
+        avx_move_forward_Nx2_load_aligned<T, 4>(first, mid, last);
+  #else
+    if (N <= 6)         // 1 -- 6,
+        avx_move_forward_Nx2_store_aligned<T, 8>(first, mid, last);
+    else if (N <= 8)    // 7, 8
+        avx_move_forward_Nx2_store_aligned<T, 6>(first, mid, last);
+    else                // 9, 10, 11, 12
+        avx_move_forward_Nx2_store_aligned<T, 4>(first, mid, last);
+  #endif
+#else
+  #if 0
+    if (N <= 6)         // 1 -- 6,
+        avx_move_forward_N_load_aligned<T, 8>(first, mid, last);
+    else if (N <= 8)    // 7, 8
+        avx_move_forward_N_load_aligned<T, 6>(first, mid, last);
+    else                // 9, 10, 11, 12
+        avx_move_forward_N_load_aligned<T, 4>(first, mid, last);
+  #elif 1
+    if (N <= 6)         // 1 -- 6,
+        avx_move_forward_N_store_aligned<T, 8, kEstimatedSize>(first, mid, last);
+    else if (N <= 8)    // 7, 8
+        avx_move_forward_N_store_aligned<T, 6, kEstimatedSize>(first, mid, last);
+    else                // 9, 10, 11, 12
+        avx_move_forward_N_store_aligned<T, 4, kEstimatedSize>(first, mid, last);
+  #else
+    if (N <= 6)         // 1 -- 6,
+        avx_move_forward_N_store_aligned_nt<T, 8>(first, mid, last);
+    else if (N <= 8)    // 7, 8
+        avx_move_forward_N_store_aligned_nt<T, 6>(first, mid, last);
+    else                // 9, 10, 11, 12
+        avx_move_forward_N_store_aligned_nt<T, 4>(first, mid, last);
+  #endif
+#endif
+}
+
+//
+// The forward move kernel chosen by the kernel profile (see ArrayRotate_Params.h).
+//
+template <typename T>
+JSTD_NO_INLINE
+void avx_move_forward_tuned(int kernel, T * first, T * mid, T * last)
+{
+    switch (kernel) {
+        case kMoveLoadAligned4:
+            avx_move_forward_N_load_aligned<T, 4>(first, mid, last);
+            break;
+        case kMoveLoadAligned6:
+            avx_move_forward_N_load_aligned<T, 6>(first, mid, last);
+            break;
+        case kMoveLoadAligned8:
+            avx_move_forward_N_load_aligned<T, 8>(first, mid, last);
+            break;
+        case kMoveStoreAligned4:
+            avx_move_forward_N_store_aligned<T, 4>(first, mid, last);
+            break;
+        case kMoveStoreAligned6:
+            avx_move_forward_N_store_aligned<T, 6>(first, mid, last);
+            break;
+        case kMoveStoreAligned8:
+            avx_move_forward_N_store_aligned<T, 8>(first, mid, last);
+            break;
+        case kMoveStoreAlignedNT4:
+            avx_move_forward_N_store_aligned_nt<T, 4>(first, mid, last);
+            break;
+        case kMoveStoreAlignedNT6:
+            avx_move_forward_N_store_aligned_nt<T, 6>(first, mid, last);
+            break;
+        case kMoveStoreAlignedNT8:
+            avx_move_forward_N_store_aligned_nt<T, 8>(first, mid, last);
+            break;
+        case kMoveNx2LoadAligned4:
+            avx_move_forward_Nx2_load_aligned<T, 4>(first, mid, last);
+            break;
+        case kMoveNx2LoadAligned6:
+            avx_move_forward_Nx2_load_aligned<T, 6>(first, mid, last);
+            break;
+        case kMoveNx2LoadAligned8:
+            avx_move_forward_Nx2_load_aligned<T, 8>(first, mid, last);
+            break;
+        case kMoveNx2StoreAligned4:
+            avx_move_forward_Nx2_store_aligned<T, 4>(first, mid, last);
+            break;
+        case kMoveNx2StoreAligned6:
+            avx_move_forward_Nx2_store_aligned<T, 6>(first, mid, last);
+            break;
+        case kMoveNx2StoreAligned8:
+            avx_move_forward_Nx2_store_aligned<T, 8>(first, mid, last);
+            break;
+        default:
+            avx_move_forward_N_load_aligned<T, 8>(first, mid, last);
+            break;
+    }
+}
+
 template <typename T>
 JSTD_FORCED_INLINE
 void left_rotate_sse_1_regs(T * first, T * mid, T * last, std::size_t left_len)
@@ -4135,7 +4739,9 @@ void left_rotate_sse_1_regs(T * first, T * mid, T * last, std::size_t left_len)
     const __m128i * stash_src = (const __m128i *)first;
     __m128i stash0 = _mm_loadu_si128(stash_src);
 
+    JSTD_ROTATE_PROBE2(simd_move_entry, std::size_t(last - mid) * sizeof(T), 0);
     avx_move_forward_N_load_aligned<T, 8>(first, mid, last);
+    JSTD_ROTATE_PROBE2(simd_move_exit, std::size_t(last - mid) * sizeof(T), 0);
 
     __m128i * stash_dest = (__m128i *)(last - left_len);
     _mm_storeu_last<T, 0>(stash_dest, stash0, left_len);
@@ -4145,8 +4751,6 @@ template <typename T, std::size_t N>
 JSTD_FORCED_INLINE
 void left_rotate_avx_N_regs(T * first, T * mid, T * last, std::size_t left_len)
 {
-    static const std::size_t kEstimatedSize = (N != 0) ? ((N - 1) * kAVXRegBytes) : 0;
-
     __m256i stash0, stash1, stash2, stash3, stash4, stash5;
     __m256i stash6, stash7, stash8, stash9, stash10, stash11;
 
@@ -4180,47 +4784,24 @@ void left_rotate_avx_N_regs(T * first, T * mid, T * last, std::size_t left_len)
 
     ////////////////////////////////////////////////////////////////////////
 
-#if defined(__clang__)
-  #if 0
-    if (N <= 6)         // 1 -- 6,
-        avx_move_forward_Nx2_load_aligned<T, 8>(first, mid, last);
-    else if (N <= 8)    // 7, 8
-        avx_move_forward_Nx2_load_aligned<T, 6>(first, mid, last);
-    else                // 9, 10, 11, 12
-        avx_move_forward_Nx2_load_aligned<T, 4>(first, mid, last);
-  #else
-    if (N <= 6)         // 1 -- 6,
-        avx_move_forward_Nx2_store_aligned<T, 8>(first, mid, last);
-    else if (N <= 8)    // 7, 8
-        avx_move_forward_Nx2_store_aligned<T, 6>(first, mid, last);
-    else                // 9, 10, 11, 12
-        avx_move_forward_Nx2_store_aligned<T, 4>(first, mid, last);
-  #endif
+    JSTD_ROTATE_PROBE2(simd_move_entry, std::size_t(last - mid) * sizeof(T), N);
+
+#if ROTATE_USE_TUNED_PROFILE
+    const RotateProfile & profile = get_rotate_profile();
+    int kernel = kMoveKernelDefault;
+    if (unlikely(profile.loaded)) {
+        kernel = profile.select(RotateProfile::stash_class(N), std::size_t(last - mid) * sizeof(T));
+    }
+    if (likely(kernel == kMoveKernelDefault))
+        avx_move_forward_default<T, N>(first, mid, last);
+    else
+        avx_move_forward_tuned(kernel, first, mid, last);
 #else
-  #if 0
-    if (N <= 6)         // 1 -- 6,
-        avx_move_forward_N_load_aligned<T, 8>(first, mid, last);
-    else if (N <= 8)    // 7, 8
-        avx_move_forward_N_load_aligned<T, 6>(first, mid, last);
-    else                // 9, 10, 11, 12
-        avx_move_forward_N_load_aligned<T, 4>(first, mid, last);
-  #elif 1
-    if (N <= 6)         // 1 -- 6,
-        avx_move_forward_N_store_aligned<T, 8, kEstimatedSize>(first, mid, last);
-    else if (N <= 8)    // 7, 8
-        avx_move_forward_N_store_aligned<T, 6, kEstimatedSize>(first, mid, last);
-    else                // 9, 10, 11, 12
-        avx_move_forward_N_store_aligned<T, 4, kEstimatedSize>(first, mid, last);
-  #else
-    if (N <= 6)         // 1 -- 6,
-        avx_move_forward_N_store_aligned_nt<T, 8>(first, mid, last);
-    else if (N <= 8)    // 7, 8
-        avx_move_forward_N_store_aligned_nt<T, 6>(first, mid, last);
-    else                // 9, 10, 11, 12
-        avx_move_forward_N_store_aligned_nt<T, 4>(first, mid, last);
-  #endif
+    avx_move_forward_default<T, N>(first, mid, last);
 #endif
 
+    JSTD_ROTATE_PROBE2(simd_move_exit, std::size_t(last - mid) * sizeof(T), N);
+
     ////////////////////////////////////////////////////////////////////////
 
     __m256i * stash_dest = (__m256i *)(last - left_len);
@@ -4304,14 +4885,57 @@ T * left_rotate_avx_chunk_swap(T * first, T * mid, T * last, std::size_t left_le
     return 0;
 }
 
+//
+// The path left_rotate_avx_impl() takes, see RotatePath. For the probes and
+// the benchmarks, it must be kept in sync with the dispatch below.
+//
+template <typename T>
+inline
+int get_rotate_path(std::size_t left_len, std::size_t right_len)
+{
+    if (!std::is_trivially_copyable<T>::value)
+        return RotatePathGeneric;
+
+    std::size_t length = left_len + right_len;
+    if (length * sizeof(T) <= kAVXRotateThresholdBytes)
+        return RotatePathSmall;
+
+    if (left_len <= right_len) {
+        std::size_t left_bytes = left_len * sizeof(T);
+        if (left_bytes <= kMaxAVXStashBytes) {
+            std::size_t avx_needs = (left_bytes - 1) / kAVXRegBytes;
+            if (avx_needs == 0 && left_bytes <= kSSERegBytes)
+                return RotatePathSSE1;
+            else
+                return (RotatePathAVX1 + (int)avx_needs);
+        } else {
+            return RotatePathLeftSimple;
+        }
+    } else {
+        return RotatePathRightSimple;
+    }
+}
+
+template <typename T>
+JSTD_FORCED_INLINE
+T * left_rotate_avx_impl(T * first, T * mid, T * last, std::size_t left_len, std::size_t right_len,
+                         std::false_type /* is_trivially_copyable */)
+{
+    // The stash kernels copy the raw bytes, only the trivially copyable types can use them.
+    JSTD_ROTATE_STATS(RotatePathGeneric, (left_len + right_len) * sizeof(T));
+    return left_rotate_simple_impl(first, mid, last, left_len, right_len);
+}
+
 template <typename T>
 JSTD_FORCED_INLINE
-T * left_rotate_avx_impl(T * first, T * mid, T * last, std::size_t left_len, std::size_t right_len)
+T * left_rotate_avx_impl(T * first, T * mid, T * last, std::size_t left_len, std::size_t right_len,
+                         std::true_type /* is_trivially_copyable */)
 {
     typedef T * pointer;
 
     std::size_t length = left_len + right_len;
     if (length * sizeof(T) <= kAVXRotateThresholdBytes) {
+        JSTD_ROTATE_STATS(RotatePathSmall, length * sizeof(T));
         return left_rotate_simple_impl(first, mid, last, left_len, right_len);
     }
 
@@ -4321,6 +4945,9 @@ T * left_rotate_avx_impl(T * first, T * mid, T * last, std::size_t left_len, std
         std::size_t left_bytes = left_len * sizeof(T);
         if (left_bytes <= kMaxAVXStashBytes) {
             std::size_t avx_needs = (left_bytes - 1) / kAVXRegBytes;
+            JSTD_ROTATE_STATS((avx_needs == 0 && left_bytes <= kSSERegBytes) ?
+                              RotatePathSSE1 : (RotatePathAVX1 + (int)avx_needs),
+                              length * sizeof(T));
             switch (avx_needs) {
                 case 0:
                     if (left_bytes <= kSSERegBytes)
@@ -4367,9 +4994,11 @@ T * left_rotate_avx_impl(T * first, T * mid, T * last, std::size_t left_len, std
             }
         }
         else {
+            JSTD_ROTATE_STATS(RotatePathLeftSimple, length * sizeof(T));
             return left_rotate_simple_impl(first, mid, last, left_len, right_len);
         }
     } else {
+        JSTD_ROTATE_STATS(RotatePathRightSimple, length * sizeof(T));
         std::size_t right_bytes = right_len * sizeof(T);
         if (right_bytes <= kMaxAVXStashBytes) {
             return right_rotate_simple_impl(first, mid, last, left_len, right_len);
@@ -4386,11 +5015,16 @@ template <typename T>
 inline
 T * left_rotate_avx(T * first, T * mid, T * last)
 {
+    typedef T * pointer;
+
+    JSTD_TRACE_SCOPE("jstd::simd::rotate");
+
+    const int prefetch_hint = get_rotate_params().prefetch_hint;
     if (kUsePrefetchHint) {
-        _mm_prefetch((const char *)first, kPrefetchHintLevel);
-        _mm_prefetch((const char *)first + 64, kPrefetchHintLevel);
-        _mm_prefetch((const char *)mid, kPrefetchHintLevel);
-        _mm_prefetch((const char *)mid + 64, kPrefetchHintLevel);
+        prefetch((const char *)first, prefetch_hint);
+        prefetch((const char *)first + 64, prefetch_hint);
+        prefetch((const char *)mid, prefetch_hint);
+        prefetch((const char *)mid + 64, prefetch_hint);
     }
 
     // If (first > mid), it's a error under DEBUG mode.
@@ -4408,7 +5042,14 @@ T * left_rotate_avx(T * first, T * mid, T * last)
     std::size_t left_len = std::size_t(s_left_len);
     std::size_t right_len = std::size_t(s_right_len);
 
-    return left_rotate_avx_impl(first, mid, last, left_len, right_len);
+    JSTD_ROTATE_PROBE3(simd_rotate_entry, left_len + right_len, left_len, sizeof(T));
+
+    pointer result = left_rotate_avx_impl(first, mid, last, left_len, right_len,
+                                          std::integral_constant<bool, std::is_trivially_copyable<T>::value>());
+
+    JSTD_ROTATE_PROBE4(simd_rotate_exit, left_len + right_len, left_len, sizeof(T),
+                       get_rotate_path<T>(left_len, right_len));
+    return result;
 }
 
 template <typename T>
@@ -4417,15 +5058,18 @@ T * left_rotate_avx(T * data, std::size_t length, std::size_t offset)
 {
     typedef T * pointer;
 
+    JSTD_TRACE_SCOPE("jstd::simd::rotate");
+
     pointer first = data;
     pointer mid   = data + offset;
     pointer last  = data + length;
 
+    const int prefetch_hint = get_rotate_params().prefetch_hint;
     if (kUsePrefetchHint) {
-        _mm_prefetch((const char *)first, kPrefetchHintLevel);
-        _mm_prefetch((const char *)first + 64, kPrefetchHintLevel);
-        _mm_prefetch((const char *)mid, kPrefetchHintLevel);
-        _mm_prefetch((const char *)mid + 64, kPrefetchHintLevel);
+        prefetch((const char *)first, prefetch_hint);
+        prefetch((const char *)first + 64, prefetch_hint);
+        prefetch((const char *)mid, prefetch_hint);
+        prefetch((const char *)mid + 64, prefetch_hint);
     }
 
     std::size_t left_len = offset;
@@ -4440,7 +5084,14 @@ T * left_rotate_avx(T * data, std::size_t length, std::size_t offset)
 
     std::size_t right_len = (std::size_t)(s_right_len);
 
-    return left_rotate_avx_impl(first, mid, last, left_len, right_len);
+    JSTD_ROTATE_PROBE3(simd_rotate_entry, length, offset, sizeof(T));
+
+    pointer result = left_rotate_avx_impl(first, mid, last, left_len, right_len,
+                                          std::integral_constant<bool, std::is_trivially_copyable<T>::value>());
+
+    JSTD_ROTATE_PROBE4(simd_rotate_exit, length, offset, sizeof(T),
+                       get_rotate_path<T>(left_len, right_len));
+    return result;
 }
 
 template <typename T>
@@ -12,6 +12,7 @@
 #include <algorithm>
 
 #include "jstd/FastMod.h"
+#include "jstd/ArrayRotate.h"
 
 namespace jstd {
 namespace v1 {
@@ -36,9 +37,8 @@ right_rotate_impl(RandomAccessIterator first, RandomAccessIterator mid, RandomAc
     RandomAccessIterator read = mid;
     RandomAccessIterator write = last;
 
-    do {
-        std::iter_swap(--read, --write);
-    } while (read != first);
+    write = detail::swap_ranges_backward(first, read, write);
+    read = first;
     write--;
 
     // Rotate the remaining sequence into place
@@ -50,10 +50,8 @@ right_rotate_impl(RandomAccessIterator first, RandomAccessIterator mid, RandomAc
             if (shift != 1) {
                 read = write - shift;
                 remain = fast_mod_u32(length, shift);
-                while (read != first) {
-                    std::iter_swap(read--, write--);
-                }
-                std::iter_swap(read, write--);
+                write = detail::swap_ranges_backward(first, read + 1, write + 1) - 1;
+                read = first;
             
                 while (remain != 0) {
                     length = shift;
@@ -61,27 +59,21 @@ right_rotate_impl(RandomAccessIterator first, RandomAccessIterator mid, RandomAc
                     if (true || shift != 1) {
                         read = write - shift;
                         remain = fast_mod_u32(length, shift);
-                        while (read != first) {
-                            std::iter_swap(read--, write--);
-                        }
-                        std::iter_swap(read, write--);
+                        write = detail::swap_ranges_backward(first, read + 1, write + 1) - 1;
+                        read = first;
                     }
                     else {
                         read = write - shift;
-                        while (read != first) {
-                            std::iter_swap(read--, write--);
-                        }
-                        std::iter_swap(read, write--);
+                        write = detail::swap_ranges_backward(first, read + 1, write + 1) - 1;
+                        read = first;
                         break;
                     }
                 }
             }
             else {
                 read = write - shift;
-                while (read != first) {
-                    std::iter_swap(read--, write--);
-                }
-                std::iter_swap(read, write--);
+                write = detail::swap_ranges_backward(first, read + 1, write + 1) - 1;
+                read = first;
             }
         }
         else {
@@ -114,9 +106,8 @@ left_rotate_impl(RandomAccessIterator first, RandomAccessIterator mid, RandomAcc
     RandomAccessIterator read = mid;
     RandomAccessIterator write = first;
 
-    do {
-        std::iter_swap(write++, read++);
-    } while (read != last);
+    write = detail::swap_ranges_forward(read, last, write);
+    read = last;
 
     // Rotate the remaining sequence into place
     if (remain0 != 0) {
@@ -128,9 +119,8 @@ left_rotate_impl(RandomAccessIterator first, RandomAccessIterator mid, RandomAcc
             if (shift != 1) {
                 read = write + shift;
                 remain = fast_mod_u32(length, shift);
-                while (read != last) {
-                    std::iter_swap(write++, read++);
-                }
+                write = detail::swap_ranges_forward(read, last, write);
+                read = last;
             
                 while (remain != 0) {
                     length = shift;
@@ -138,24 +128,21 @@ left_rotate_impl(RandomAccessIterator first, RandomAccessIterator mid, RandomAcc
                     if (true || shift != 1) {
                         read = write + shift;
                         remain = fast_mod_u32(length, shift);
-                        while (read != last) {
-                            std::iter_swap(write++, read++);
-                        }
+                        write = detail::swap_ranges_forward(read, last, write);
+                        read = last;
                     }
                     else {
                         read = write + shift;
-                        while (read != last) {
-                            std::iter_swap(write++, read++);
-                        }
+                        write = detail::swap_ranges_forward(read, last, write);
+                        read = last;
                         break;
                     }
                 }
             }
             else {
                 read = write + shift;
-                while (read != last) {
-                    std::iter_swap(write++, read++);
-                }
+                write = detail::swap_ranges_forward(read, last, write);
+                read = last;
             }
         }
         else {
@@ -42,9 +42,10 @@ std::uint32_t floorLog2(Integal val)
         return log2_i;
     }
 
-    std::size_t power2 = 1;
+    // (val >> 1) < power2 is (val < power2 * 2) without overflow at the top bit.
+    Integal power2 = 1;
     do {
-        if (val > power2 && val < power2 * 2) {
+        if (val > power2 && (val >> 1) < power2) {
             return log2_i;
         }
         power2 <<= 1;
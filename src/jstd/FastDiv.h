@@ -2256,18 +2256,219 @@ std::uint32_t fast_div_u32(std::uint32_t value, std::uint32_t divisor)
 
 #endif // __amd64__
 
+//
+// The divider of any 32-bit divisor (libdivide style), the ratio is computed
+// once at runtime, then each division is branchfree, for any 32-bit value:
+//
+//   q = (n * mul + add) >> shift       (the 64-bit product, shift = 32 + k)
+//
+// where k = floor(log2(d)). If the error of the round up ratio is small enough
+// (mul * d - 2^(32 + k) < 2^k), use it and add = 0, otherwise use the round down
+// ratio and add = mul, that is (n + 1) * mul ("round down and increment",
+// see: ridiculousfish, "Labor of Division (Episode III)").
+//
+// The divisor 1 uses mul = add = 0xFFFFFFFF, shift = 32, like div_ratio_tbl32_64.
+//
+class FastDivider32 {
+private:
+    std::uint32_t divisor_;
+    std::uint32_t mul_;
+    std::uint32_t add_;
+    std::uint32_t shift_;
+
+public:
+    FastDivider32() : divisor_(1), mul_(0xFFFFFFFFul), add_(0xFFFFFFFFul), shift_(32) {}
+
+    explicit FastDivider32(std::uint32_t divisor) {
+        this->set_divisor(divisor);
+    }
+
+    std::uint32_t divisor() const { return this->divisor_; }
+
+    DivRatio32 ratio() const {
+        DivRatio32 divRatio;
+        divRatio.mul = this->mul_;
+        divRatio.add = this->add_;
+        divRatio.shift = this->shift_;
+        divRatio.reserve = 0;
+        return divRatio;
+    }
+
+    void set_divisor(std::uint32_t divisor) {
+        assert(divisor != 0);
+        this->divisor_ = divisor;
+        if (divisor == 1) {
+            this->mul_ = 0xFFFFFFFFul;
+            this->add_ = 0xFFFFFFFFul;
+            this->shift_ = 32;
+            return;
+        }
+
+        std::uint32_t shift = floorLog2<std::uint32_t>(divisor);
+        if ((divisor & (divisor - 1)) == 0) {
+            this->mul_ = 1ul << (32 - shift);
+            this->add_ = 0;
+            this->shift_ = 32;
+        } else {
+            // m = 2 ^ (32 + k)
+            std::uint64_t m_64 = (std::uint64_t)1u << (32 + shift);
+            std::uint32_t multi_down = (std::uint32_t)(m_64 / divisor);
+            std::uint32_t remainder = (std::uint32_t)(m_64 % divisor);
+            // err = multi_up * d - m
+            std::uint32_t err = divisor - remainder;
+            if (err < (1ul << shift)) {
+                this->mul_ = multi_down + 1;
+                this->add_ = 0;
+            } else {
+                this->mul_ = multi_down;
+                this->add_ = multi_down;
+            }
+            this->shift_ = 32 + shift;
+        }
+    }
+
+    // n * mul + add <= (2^32 - 1) * (2^32 - 1) + (2^32 - 1) < 2^64, never overflows.
+    JSTD_FORCED_INLINE
+    std::uint32_t divide(std::uint32_t value) const {
+        return (std::uint32_t)(((std::uint64_t)value * this->mul_ + this->add_) >> this->shift_);
+    }
+
+    JSTD_FORCED_INLINE
+    std::uint32_t modulus(std::uint32_t value) const {
+        return (value - this->divide(value) * this->divisor_);
+    }
+};
+
+static inline
+std::uint32_t operator / (std::uint32_t value, const FastDivider32 & divider)
+{
+    return divider.divide(value);
+}
+
+static inline
+std::uint32_t operator % (std::uint32_t value, const FastDivider32 & divider)
+{
+    return divider.modulus(value);
+}
+
+//
+// q = (n * mul + add) >> (64 + shift), the 128-bit sum, for any 64-bit value.
+// add is 0 (the round up ratio) or mul (the round down ratio, that is (n + 1) * mul),
+// the sum never overflows: (2^64 - 1) * mul + mul = 2^64 * mul.
+//
+static inline
+std::uint64_t fast_div_u64(std::uint64_t value, const DivRatio64 & ratio)
+{
+    std::uint64_t product_low  = value * ratio.mul;
+    std::uint64_t product_high = mul_u64x64_high(value, ratio.mul);
+    std::uint64_t sum_low = product_low + ratio.add;
+    product_high += (sum_low < product_low) ? 1 : 0;
+    return (product_high >> ratio.shift);
+}
+
+//
+// Only the divisors below kMaxDivTable have a precomputed ratio, a ratio of the
+// other divisors costs a 128-bit division, so a single division uses div,
+// use FastDivider64 if the divisor is used many times.
+//
 static inline
 std::uint64_t fast_div_u64(std::uint64_t value, std::uint64_t divisor)
 {
     if (divisor < kMaxDivTable) {
-        DivRatio64 rt = div_ratio_tbl64[divisor];
-        std::uint64_t result = (mul_u64x64_high_ex(value, rt.mul) >> rt.shift);
-        return result;
+        return fast_div_u64(value, div_ratio_tbl64[divisor]);
     } else {
         return (value / divisor);
     }
 }
 
+//
+// The divider of any 64-bit divisor, the same scheme as FastDivider32 with a 128-bit
+// product: the ratio is computed once at runtime (a 128-bit division), exactly,
+// without the floating-point error estimation of preComputeDiv_u64():
+//
+//   k = floor(log2(d)), m = 2^(64 + k)
+//
+//   err = ceil(m / d) * d - m < 2^k :  mul = ceil(m / d),  add = 0
+//   otherwise                       :  mul = floor(m / d), add = mul
+//
+// The power of 2 divisors: mul = 2^(64 - k), add = 0, shift = 0,
+// and the divisor 1: mul = add = 0xFFFFFFFFFFFFFFFF, shift = 0, like div_ratio_tbl64.
+//
+class FastDivider64 {
+private:
+    std::uint64_t divisor_;
+    DivRatio64    ratio_;
+
+public:
+    FastDivider64() : divisor_(1) {
+        this->ratio_ = div_ratio_tbl64[1];
+    }
+
+    explicit FastDivider64(std::uint64_t divisor) {
+        this->set_divisor(divisor);
+    }
+
+    std::uint64_t divisor() const { return this->divisor_; }
+    const DivRatio64 & ratio() const { return this->ratio_; }
+
+    void set_divisor(std::uint64_t divisor) {
+        assert(divisor != 0);
+        this->divisor_ = divisor;
+        this->ratio_.reserve = 0;
+        if (divisor == 1) {
+            this->ratio_.mul = 0xFFFFFFFFFFFFFFFFull;
+            this->ratio_.add = 0xFFFFFFFFFFFFFFFFull;
+            this->ratio_.shift = 0;
+            return;
+        }
+
+        std::uint32_t shift = floorLog2<std::uint64_t>(divisor);
+        if ((divisor & (divisor - 1)) == 0) {
+            this->ratio_.mul = 1ull << (64 - shift);
+            this->ratio_.add = 0;
+            this->ratio_.shift = 0;
+        } else {
+            // m = 2 ^ (64 + k)
+            _uint128_t m_128((std::uint64_t)1u << shift, (std::uint64_t)0u);
+            std::uint64_t multi_down = (std::uint64_t)(m_128 / _uint128_t(divisor));
+            // r = m - multi_down * d, the low 64 bits of m are 0.
+            std::uint64_t remainder = (std::uint64_t)0u - multi_down * divisor;
+            // err = multi_up * d - m
+            std::uint64_t err = divisor - remainder;
+            if (err < ((std::uint64_t)1u << shift)) {
+                this->ratio_.mul = multi_down + 1;
+                this->ratio_.add = 0;
+            } else {
+                this->ratio_.mul = multi_down;
+                this->ratio_.add = multi_down;
+            }
+            this->ratio_.shift = shift;
+        }
+    }
+
+    JSTD_FORCED_INLINE
+    std::uint64_t divide(std::uint64_t value) const {
+        return fast_div_u64(value, this->ratio_);
+    }
+
+    JSTD_FORCED_INLINE
+    std::uint64_t modulus(std::uint64_t value) const {
+        return (value - this->divide(value) * this->divisor_);
+    }
+};
+
+static inline
+std::uint64_t operator / (std::uint64_t value, const FastDivider64 & divider)
+{
+    return divider.divide(value);
+}
+
+static inline
+std::uint64_t operator % (std::uint64_t value, const FastDivider64 & divider)
+{
+    return divider.modulus(value);
+}
+
 } // namespace jstd
 
 #endif // JSTD_FAST_DIV_H
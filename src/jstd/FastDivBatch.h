@@ -0,0 +1,385 @@
+
+#ifndef JSTD_FAST_DIV_BATCH_H
+#define JSTD_FAST_DIV_BATCH_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+
+#include <cstdint>
+#include <cstddef>
+
+#include "jstd/stddef.h"
+#include "jstd/uint128_t.h"
+#include "jstd/DivUtils.h"
+#include "jstd/FastDiv.h"
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+//
+// Divide or modulo the whole array by one divisor, the ratio is computed once:
+//
+//   jstd::fast_div_batch(src, dest, count, divisor);   // dest[i] = src[i] / divisor
+//   jstd::fast_mod_batch(src, dest, count, divisor);   // dest[i] = src[i] % divisor
+//
+// src and dest may be the same array, the divisor must not be 0.
+//
+// uint32_t: q = (n * mul + add) >> shift, the FastDivider32 ratio, the 64-bit
+//           products of the even and odd lanes by _mm256_mul_epu32 (8 per loop),
+//           or _mm512_mul_epu32 under AVX-512F (16 per loop).
+//
+// uint64_t: q = mulhi64(n + inc, mul) >> shift (the round up ratio, or the round
+//           down ratio with a saturating increment), the 64x64 high half is made of
+//           four _mm256_mul_epu32 (4 per loop) or _mm512_mul_epu32 (8 per loop),
+//           the modulo uses vpmullq under AVX-512DQ. The power of 2 divisors are
+//           only a shift.
+//
+// AVX-512 IFMA (vpmadd52huq) only has 52-bit products, it can't give the 64-bit
+// high half of a full 64-bit ratio cheaper than four vpmuludq, so it's not used.
+//
+
+namespace jstd {
+
+struct DivBatchRatio64 {
+    std::uint64_t mul;
+    std::uint64_t inc;      // 1: use (n + 1) with the round down ratio
+    std::uint32_t shift;
+    std::uint32_t is_pow2;
+};
+
+//
+// The FastDivider64 ratio, with the increment instead of add = mul: SIMD has no
+// cheap 128-bit add, mulhi64(n + 1, mul) is the same but n + 1 must saturate.
+//
+static inline
+DivBatchRatio64 preComputeDivBatch_u64(std::uint64_t divisor)
+{
+    assert(divisor != 0);
+    DivBatchRatio64 ratio;
+    if ((divisor & (divisor - 1)) == 0) {
+        ratio.mul = 0;
+        ratio.inc = 0;
+        ratio.shift = floorLog2<std::uint64_t>(divisor);
+        ratio.is_pow2 = 1;
+    } else {
+        FastDivider64 divider(divisor);
+        ratio.mul = divider.ratio().mul;
+        ratio.inc = (divider.ratio().add != 0) ? 1 : 0;
+        ratio.shift = divider.ratio().shift;
+        ratio.is_pow2 = 0;
+    }
+    return ratio;
+}
+
+namespace detail {
+
+JSTD_FORCED_INLINE
+std::uint64_t batch_div_u64(std::uint64_t value, const DivBatchRatio64 & ratio)
+{
+    // The saturating increment: the max value stays the max value.
+    std::uint64_t n = value + ratio.inc;
+    n -= (n == 0) ? ratio.inc : 0;
+    return (mul_u64x64_high(n, ratio.mul) >> ratio.shift);
+}
+
+#if defined(__AVX2__)
+
+JSTD_FORCED_INLINE
+__m256i batch_div_u32x8(__m256i value, __m256i mul, __m256i add,
+                        __m128i shift, __m128i shift_odd)
+{
+    __m256i value_odd = _mm256_srli_epi64(value, 32);
+    __m256i even = _mm256_add_epi64(_mm256_mul_epu32(value, mul), add);
+    __m256i odd  = _mm256_add_epi64(_mm256_mul_epu32(value_odd, mul), add);
+    // The even quotients are in the low half, the odd quotients in the high half.
+    even = _mm256_srl_epi64(even, shift);
+    odd  = _mm256_srl_epi64(odd, shift_odd);
+    return _mm256_blend_epi32(even, odd, 0xAA);
+}
+
+JSTD_FORCED_INLINE
+__m256i batch_mulhi_u64x4(__m256i a, __m256i b, __m256i b_hi)
+{
+    const __m256i mask32 = _mm256_set1_epi64x(0xFFFFFFFFll);
+    __m256i a_hi = _mm256_srli_epi64(a, 32);
+    __m256i ll = _mm256_mul_epu32(a, b);
+    __m256i lh = _mm256_mul_epu32(a, b_hi);
+    __m256i hl = _mm256_mul_epu32(a_hi, b);
+    __m256i hh = _mm256_mul_epu32(a_hi, b_hi);
+    __m256i mid = _mm256_add_epi64(_mm256_srli_epi64(ll, 32), _mm256_and_si256(lh, mask32));
+    mid = _mm256_add_epi64(mid, _mm256_and_si256(hl, mask32));
+    __m256i hi = _mm256_add_epi64(hh, _mm256_srli_epi64(lh, 32));
+    hi = _mm256_add_epi64(hi, _mm256_srli_epi64(hl, 32));
+    return _mm256_add_epi64(hi, _mm256_srli_epi64(mid, 32));
+}
+
+// The low 64 bits of a * b.
+JSTD_FORCED_INLINE
+__m256i batch_mullo_u64x4(__m256i a, __m256i b, __m256i b_hi)
+{
+    __m256i a_hi = _mm256_srli_epi64(a, 32);
+    __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(a_hi, b), _mm256_mul_epu32(a, b_hi));
+    return _mm256_add_epi64(_mm256_mul_epu32(a, b), _mm256_slli_epi64(cross, 32));
+}
+
+JSTD_FORCED_INLINE
+__m256i batch_div_u64x4(__m256i value, __m256i mul, __m256i mul_hi, __m256i inc, __m128i shift)
+{
+    __m256i n = _mm256_add_epi64(value, inc);
+    __m256i wrapped = _mm256_cmpeq_epi64(n, _mm256_setzero_si256());
+    n = _mm256_sub_epi64(n, _mm256_and_si256(wrapped, inc));
+    return _mm256_srl_epi64(batch_mulhi_u64x4(n, mul, mul_hi), shift);
+}
+
+#endif // __AVX2__
+
+#if defined(__AVX512F__)
+
+//
+// The unmasked _mm512_mul_epu32(), _mm512_srli_epi64() and _mm512_srl_epi64()
+// of gcc 12 pass _mm512_undefined_epi32() as the merge source, and it warns
+// -Wmaybe-uninitialized ('__Y') wherever they are inlined. The zero-masked forms
+// with a full mask are the same instructions, without the undefined source.
+//
+static const __mmask8 kBatchMaskAll8 = (__mmask8)0xFF;
+
+JSTD_FORCED_INLINE
+__m512i batch_mul_epu32x8(__m512i a, __m512i b)
+{
+    return _mm512_maskz_mul_epu32(kBatchMaskAll8, a, b);
+}
+
+JSTD_FORCED_INLINE
+__m512i batch_srli32_epi64x8(__m512i a)
+{
+    return _mm512_maskz_srli_epi64(kBatchMaskAll8, a, 32);
+}
+
+JSTD_FORCED_INLINE
+__m512i batch_slli32_epi64x8(__m512i a)
+{
+    return _mm512_maskz_slli_epi64(kBatchMaskAll8, a, 32);
+}
+
+JSTD_FORCED_INLINE
+__m512i batch_srl_epi64x8(__m512i a, __m128i shift)
+{
+    return _mm512_maskz_srl_epi64(kBatchMaskAll8, a, shift);
+}
+
+JSTD_FORCED_INLINE
+__m512i batch_div_u32x16(__m512i value, __m512i mul, __m512i add,
+                         __m128i shift, __m128i shift_odd)
+{
+    __m512i value_odd = batch_srli32_epi64x8(value);
+    __m512i even = _mm512_add_epi64(batch_mul_epu32x8(value, mul), add);
+    __m512i odd  = _mm512_add_epi64(batch_mul_epu32x8(value_odd, mul), add);
+    even = batch_srl_epi64x8(even, shift);
+    odd  = batch_srl_epi64x8(odd, shift_odd);
+    return _mm512_mask_blend_epi32((__mmask16)0xAAAA, even, odd);
+}
+
+JSTD_FORCED_INLINE
+__m512i batch_mulhi_u64x8(__m512i a, __m512i b, __m512i b_hi)
+{
+    const __m512i mask32 = _mm512_set1_epi64(0xFFFFFFFFll);
+    __m512i a_hi = batch_srli32_epi64x8(a);
+    __m512i ll = batch_mul_epu32x8(a, b);
+    __m512i lh = batch_mul_epu32x8(a, b_hi);
+    __m512i hl = batch_mul_epu32x8(a_hi, b);
+    __m512i hh = batch_mul_epu32x8(a_hi, b_hi);
+    __m512i mid = _mm512_add_epi64(batch_srli32_epi64x8(ll), _mm512_and_si512(lh, mask32));
+    mid = _mm512_add_epi64(mid, _mm512_and_si512(hl, mask32));
+    __m512i hi = _mm512_add_epi64(hh, batch_srli32_epi64x8(lh));
+    hi = _mm512_add_epi64(hi, batch_srli32_epi64x8(hl));
+    return _mm512_add_epi64(hi, batch_srli32_epi64x8(mid));
+}
+
+JSTD_FORCED_INLINE
+__m512i batch_mullo_u64x8(__m512i a, __m512i b, __m512i b_hi)
+{
+#if defined(__AVX512DQ__)
+    (void)b_hi;
+    return _mm512_mullo_epi64(a, b);
+#else
+    __m512i a_hi = batch_srli32_epi64x8(a);
+    __m512i cross = _mm512_add_epi64(batch_mul_epu32x8(a_hi, b), batch_mul_epu32x8(a, b_hi));
+    return _mm512_add_epi64(batch_mul_epu32x8(a, b), batch_slli32_epi64x8(cross));
+#endif
+}
+
+JSTD_FORCED_INLINE
+__m512i batch_div_u64x8(__m512i value, __m512i mul, __m512i mul_hi, __m512i inc, __m128i shift)
+{
+    __m512i n = _mm512_add_epi64(value, inc);
+    __mmask8 wrapped = _mm512_cmpeq_epu64_mask(n, _mm512_setzero_si512());
+    n = _mm512_mask_sub_epi64(n, wrapped, n, inc);
+    return batch_srl_epi64x8(batch_mulhi_u64x8(n, mul, mul_hi), shift);
+}
+
+#endif // __AVX512F__
+
+template <bool IsModulo>
+static inline
+void fast_div_batch_u32(const std::uint32_t * src, std::uint32_t * dest, std::size_t count,
+                        const FastDivider32 & divider)
+{
+    std::uint32_t divisor = divider.divisor();
+    std::size_t i = 0;
+
+#if defined(__AVX512F__)
+    {
+        const DivRatio32 ratio = divider.ratio();
+        const __m512i mul = _mm512_set1_epi64((long long)ratio.mul);
+        const __m512i add = _mm512_set1_epi64((long long)ratio.add);
+        const __m512i vdivisor = _mm512_set1_epi32((int)divisor);
+        const __m128i shift = _mm_cvtsi32_si128((int)ratio.shift);
+        const __m128i shift_odd = _mm_cvtsi32_si128((int)ratio.shift - 32);
+        for (; i + 16 <= count; i += 16) {
+            __m512i value = _mm512_loadu_si512((const void *)(src + i));
+            __m512i result = batch_div_u32x16(value, mul, add, shift, shift_odd);
+            if (IsModulo)
+                result = _mm512_sub_epi32(value, _mm512_mullo_epi32(result, vdivisor));
+            _mm512_storeu_si512((void *)(dest + i), result);
+        }
+    }
+#endif
+
+#if defined(__AVX2__)
+    {
+        const DivRatio32 ratio = divider.ratio();
+        const __m256i mul = _mm256_set1_epi64x((long long)ratio.mul);
+        const __m256i add = _mm256_set1_epi64x((long long)ratio.add);
+        const __m256i vdivisor = _mm256_set1_epi32((int)divisor);
+        const __m128i shift = _mm_cvtsi32_si128((int)ratio.shift);
+        const __m128i shift_odd = _mm_cvtsi32_si128((int)ratio.shift - 32);
+        for (; i + 8 <= count; i += 8) {
+            __m256i value = _mm256_loadu_si256((const __m256i *)(src + i));
+            __m256i result = batch_div_u32x8(value, mul, add, shift, shift_odd);
+            if (IsModulo)
+                result = _mm256_sub_epi32(value, _mm256_mullo_epi32(result, vdivisor));
+            _mm256_storeu_si256((__m256i *)(dest + i), result);
+        }
+    }
+#endif
+
+    for (; i < count; i++) {
+        std::uint32_t value = src[i];
+        std::uint32_t quotient = divider.divide(value);
+        dest[i] = IsModulo ? (value - quotient * divisor) : quotient;
+    }
+}
+
+template <bool IsModulo>
+static inline
+void fast_div_batch_u64(const std::uint64_t * src, std::uint64_t * dest, std::size_t count,
+                        std::uint64_t divisor)
+{
+    DivBatchRatio64 ratio = preComputeDivBatch_u64(divisor);
+    if (ratio.is_pow2) {
+        std::uint64_t mask = divisor - 1;
+        std::uint32_t shift = ratio.shift;
+        for (std::size_t i = 0; i < count; i++) {
+            dest[i] = IsModulo ? (src[i] & mask) : (src[i] >> shift);
+        }
+        return;
+    }
+
+    std::size_t i = 0;
+
+#if defined(__AVX512F__)
+    {
+        const __m512i mul = _mm512_set1_epi64((long long)ratio.mul);
+        const __m512i mul_hi = _mm512_set1_epi64((long long)(ratio.mul >> 32));
+        const __m512i inc = _mm512_set1_epi64((long long)ratio.inc);
+        const __m512i vdivisor = _mm512_set1_epi64((long long)divisor);
+        const __m512i vdivisor_hi = _mm512_set1_epi64((long long)(divisor >> 32));
+        const __m128i shift = _mm_cvtsi32_si128((int)ratio.shift);
+        for (; i + 8 <= count; i += 8) {
+            __m512i value = _mm512_loadu_si512((const void *)(src + i));
+            __m512i result = batch_div_u64x8(value, mul, mul_hi, inc, shift);
+            if (IsModulo)
+                result = _mm512_sub_epi64(value, batch_mullo_u64x8(result, vdivisor, vdivisor_hi));
+            _mm512_storeu_si512((void *)(dest + i), result);
+        }
+    }
+#endif
+
+#if defined(__AVX2__)
+    {
+        const __m256i mul = _mm256_set1_epi64x((long long)ratio.mul);
+        const __m256i mul_hi = _mm256_set1_epi64x((long long)(ratio.mul >> 32));
+        const __m256i inc = _mm256_set1_epi64x((long long)ratio.inc);
+        const __m256i vdivisor = _mm256_set1_epi64x((long long)divisor);
+        const __m256i vdivisor_hi = _mm256_set1_epi64x((long long)(divisor >> 32));
+        const __m128i shift = _mm_cvtsi32_si128((int)ratio.shift);
+        for (; i + 4 <= count; i += 4) {
+            __m256i value = _mm256_loadu_si256((const __m256i *)(src + i));
+            __m256i result = batch_div_u64x4(value, mul, mul_hi, inc, shift);
+            if (IsModulo)
+                result = _mm256_sub_epi64(value, batch_mullo_u64x4(result, vdivisor, vdivisor_hi));
+            _mm256_storeu_si256((__m256i *)(dest + i), result);
+        }
+    }
+#endif
+
+    for (; i < count; i++) {
+        std::uint64_t value = src[i];
+        std::uint64_t quotient = batch_div_u64(value, ratio);
+        dest[i] = IsModulo ? (value - quotient * divisor) : quotient;
+    }
+}
+
+} // namespace detail
+
+static inline
+void fast_div_batch(const std::uint32_t * src, std::uint32_t * dest, std::size_t count,
+                    const FastDivider32 & divider)
+{
+    detail::fast_div_batch_u32<false>(src, dest, count, divider);
+}
+
+static inline
+void fast_div_batch(const std::uint32_t * src, std::uint32_t * dest, std::size_t count,
+                    std::uint32_t divisor)
+{
+    detail::fast_div_batch_u32<false>(src, dest, count, FastDivider32(divisor));
+}
+
+static inline
+void fast_mod_batch(const std::uint32_t * src, std::uint32_t * dest, std::size_t count,
+                    const FastDivider32 & divider)
+{
+    detail::fast_div_batch_u32<true>(src, dest, count, divider);
+}
+
+static inline
+void fast_mod_batch(const std::uint32_t * src, std::uint32_t * dest, std::size_t count,
+                    std::uint32_t divisor)
+{
+    detail::fast_div_batch_u32<true>(src, dest, count, FastDivider32(divisor));
+}
+
+static inline
+void fast_div_batch(const std::uint64_t * src, std::uint64_t * dest, std::size_t count,
+                    std::uint64_t divisor)
+{
+    detail::fast_div_batch_u64<false>(src, dest, count, divisor);
+}
+
+static inline
+void fast_mod_batch(const std::uint64_t * src, std::uint64_t * dest, std::size_t count,
+                    std::uint64_t divisor)
+{
+    detail::fast_div_batch_u64<true>(src, dest, count, divisor);
+}
+
+} // namespace jstd
+
+#endif // JSTD_FAST_DIV_BATCH_H
@@ -1725,16 +1725,117 @@ std::uint32_t fast_mod_u32(std::uint32_t value, std::uint32_t divisor)
     }
 }
 
+//
+// With the runtime precomputed ratio (preComputeMod_u32(divisor)), there is no
+// table lookup and no branch, for any 32-bit value and divisor.
+//
+static inline
+std::uint32_t fast_mod_u32(std::uint32_t value, std::uint32_t divisor, const ModRatio32 & ratio)
+{
+    std::uint64_t low64_bits = (std::uint64_t)value * ratio.mul;
+    std::uint32_t result = (std::uint32_t)mul_u64x32_high(low64_bits, divisor);
+    return result;
+}
+
+//
+// The modulus of any 32-bit divisor, the ratio (Lemire's M = ceil(2^64 / d)) is
+// computed once at runtime, then each modulus is two multiplies, no branch and
+// no table lookup, for any 32-bit value. The divisor 1 has M = 0, that is right.
+//
+class FastModulus32 {
+private:
+    std::uint32_t   divisor_;
+    ModRatio32      ratio_;
+
+public:
+    FastModulus32() : divisor_(1) {
+        this->ratio_.mul = 0;
+    }
+
+    explicit FastModulus32(std::uint32_t divisor) {
+        this->set_divisor(divisor);
+    }
+
+    std::uint32_t divisor() const { return this->divisor_; }
+    const ModRatio32 & ratio() const { return this->ratio_; }
+
+    void set_divisor(std::uint32_t divisor) {
+        assert(divisor != 0);
+        this->divisor_ = divisor;
+        this->ratio_ = preComputeMod_u32(divisor);
+    }
+
+    JSTD_FORCED_INLINE
+    std::uint32_t modulus(std::uint32_t value) const {
+        return fast_mod_u32(value, this->divisor_, this->ratio_);
+    }
+
+    // (value % d == 0) <==> (value * M <= M - 1), see Lemire et al. 2019.
+    JSTD_FORCED_INLINE
+    bool is_divisible(std::uint32_t value) const {
+        return ((std::uint64_t)value * this->ratio_.mul <= this->ratio_.mul - 1);
+    }
+};
+
+static inline
+std::uint32_t operator % (std::uint32_t value, const FastModulus32 & modulus)
+{
+    return modulus.modulus(value);
+}
+
+//
+// For a divisor that is used only once, like the Euclid steps of the rotations,
+// where precomputing a FastModulus32 costs a 64-bit division itself: the quotients
+// 1 and 2 (the most frequent ones) are subtractions, the small divisors use
+// the table, the others use the hardware division.
+//
+static inline
+std::uint32_t fast_mod_u32_once(std::uint32_t value, std::uint32_t divisor)
+{
+    if (value < divisor)
+        return value;
+    value -= divisor;
+    if (value < divisor)
+        return value;
+    value -= divisor;
+    if (value < divisor)
+        return value;
+    return fast_mod_u32(value, divisor);
+}
+
+//
+// The high 64 bits of the 192-bit product (lowbits * d), lowbits is 128 bits.
+// See mul128_u64() of https://github.com/lemire/fastmod
+//
+static inline
+std::uint64_t mul_u128x64_high(std::uint64_t low, std::uint64_t high, std::uint64_t divisor)
+{
+    std::uint64_t bottom_half = mul_u64x64_high(low, divisor);
+    std::uint64_t top_low  = high * divisor;
+    std::uint64_t top_high = mul_u64x64_high(high, divisor);
+    std::uint64_t middle = top_low + bottom_half;
+    return (top_high + ((middle < top_low) ? 1 : 0));
+}
+
+//
+// Lemire's fastmod_u64(): M = ceil(2^128 / d), lowbits = M * value (mod 2^128),
+// value % d = (lowbits * d) >> 128, for any 64-bit value and divisor.
+//
+static inline
+std::uint64_t fast_mod_u64(std::uint64_t value, std::uint64_t divisor, const ModRatio64 & ratio)
+{
+    std::uint64_t lowbits_low  = ratio.mul_low * value;
+    std::uint64_t lowbits_high = ratio.mul_high * value + mul_u64x64_high(ratio.mul_low, value);
+    return mul_u128x64_high(lowbits_low, lowbits_high, divisor);
+}
+
 static inline
 std::uint64_t fast_mod_u64(std::uint64_t value, std::uint32_t divisor)
 {
     if (divisor >= kMaxModTable) {
         return (value % divisor);
     } else {
-        ModRatio32 rt = mod_ratio_tbl32[divisor];
-        std::uint64_t low64_bits = value * rt.mul;
-        std::uint32_t result = (std::uint32_t)mul_u64x32_high(low64_bits, divisor);
-        return result;
+        return fast_mod_u64(value, (std::uint64_t)divisor, mod_ratio_tbl64[divisor]);
     }
 }
 
@@ -1744,11 +1845,68 @@ std::uint64_t fast_mod_u64(std::uint64_t value, std::uint64_t divisor)
     if (divisor >= kMaxModTable) {
         return (value % divisor);
     } else {
-        ModRatio32 rt = mod_ratio_tbl32[divisor];
-        std::uint64_t low64_bits = value * rt.mul;
-        std::uint32_t result = (std::uint32_t)mul_u64x64_high(low64_bits, divisor);
-        return result;
+        return fast_mod_u64(value, divisor, mod_ratio_tbl64[divisor]);
+    }
+}
+
+//
+// The modulus of any 64-bit divisor, the ratio (M = ceil(2^128 / d)) is computed
+// once at runtime (a 128-bit division), then each modulus is five multiplies.
+//
+class FastModulus64 {
+private:
+    std::uint64_t   divisor_;
+    ModRatio64      ratio_;
+
+public:
+    FastModulus64() : divisor_(1) {
+        this->ratio_.mul_low = 0;
+        this->ratio_.mul_high = 0;
     }
+
+    explicit FastModulus64(std::uint64_t divisor) {
+        this->set_divisor(divisor);
+    }
+
+    std::uint64_t divisor() const { return this->divisor_; }
+    const ModRatio64 & ratio() const { return this->ratio_; }
+
+    void set_divisor(std::uint64_t divisor) {
+        assert(divisor != 0);
+        this->divisor_ = divisor;
+        if (divisor < kMaxModTable)
+            this->ratio_ = mod_ratio_tbl64[divisor];
+        else
+            this->ratio_ = preComputeMod_u64(divisor);
+    }
+
+    JSTD_FORCED_INLINE
+    std::uint64_t modulus(std::uint64_t value) const {
+        return fast_mod_u64(value, this->divisor_, this->ratio_);
+    }
+};
+
+static inline
+std::uint64_t operator % (std::uint64_t value, const FastModulus64 & modulus)
+{
+    return modulus.modulus(value);
+}
+
+//
+// Same as fast_mod_u32_once(), for the 64-bit values.
+//
+static inline
+std::uint64_t fast_mod_u64_once(std::uint64_t value, std::uint64_t divisor)
+{
+    if (value < divisor)
+        return value;
+    value -= divisor;
+    if (value < divisor)
+        return value;
+    value -= divisor;
+    if (value < divisor)
+        return value;
+    return fast_mod_u64(value, divisor);
 }
 
 } // namespace jstd
@@ -0,0 +1,224 @@
+
+#ifndef JSTD_INPLACE_MERGE_H
+#define JSTD_INPLACE_MERGE_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdbool>
+#include <cstring>
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+
+#include "jstd/stddef.h"
+#include "jstd/ArrayRotate_SIMD.h"
+
+//
+// In-place merge of two sorted ranges [first, mid) and [mid, last).
+//
+// Without a buffer, it's the SymMerge algorithm (Kim & Kutzner), all the data
+// movement is done by rotations of all sizes, so it's built on jstd::simd::rotate().
+// When a scratch buffer (arena) is given, any sub-merge whose shorter side fits
+// in the buffer is done by a linear buffered merge instead.
+//
+// The merge is stable, like std::inplace_merge().
+//
+// See: https://link.springer.com/chapter/10.1007/978-3-540-30140-0_63
+// See: https://github.com/golang/go/blob/master/src/sort/zsortfunc.go (symMerge_func)
+//
+
+namespace jstd {
+
+namespace detail {
+
+//
+// Copy [first, mid) to the buffer, then merge forward.
+// The tail of [mid, last) is already in place when the buffer runs out.
+//
+template <typename T, typename Compare>
+void merge_with_buffer_forward(T * first, T * mid, T * last, T * buffer, Compare & comp)
+{
+    std::size_t left_len = std::size_t(mid - first);
+    std::memcpy((void *)buffer, (const void *)first, left_len * sizeof(T));
+
+    T * left = buffer;
+    T * left_end = buffer + left_len;
+    T * right = mid;
+    T * dest = first;
+
+    while (left != left_end && right != last) {
+        if (comp(*right, *left))
+            *dest++ = *right++;
+        else
+            *dest++ = *left++;
+    }
+
+    if (left != left_end) {
+        std::memcpy((void *)dest, (const void *)left, std::size_t(left_end - left) * sizeof(T));
+    }
+}
+
+//
+// Copy [mid, last) to the buffer, then merge backward.
+// The head of [first, mid) is already in place when the buffer runs out.
+//
+template <typename T, typename Compare>
+void merge_with_buffer_backward(T * first, T * mid, T * last, T * buffer, Compare & comp)
+{
+    std::size_t right_len = std::size_t(last - mid);
+    std::memcpy((void *)buffer, (const void *)mid, right_len * sizeof(T));
+
+    T * left_end = mid;
+    T * right_end = buffer + right_len;
+    T * dest = last;
+
+    while (left_end != first && right_end != buffer) {
+        if (comp(*(right_end - 1), *(left_end - 1)))
+            *--dest = *--left_end;
+        else
+            *--dest = *--right_end;
+    }
+
+    if (right_end != buffer) {
+        std::memcpy((void *)first, (const void *)buffer, std::size_t(right_end - buffer) * sizeof(T));
+    }
+}
+
+template <typename T, typename Compare>
+void sym_merge_impl(T * first, T * mid, T * last,
+                    T * buffer, std::size_t buffer_size, Compare & comp)
+{
+    if (first == mid || mid == last)
+        return;
+
+    // The two ranges are already in order.
+    if (!comp(*mid, *(mid - 1)))
+        return;
+
+    // Trim the elements that are already in the final position:
+    // [first, new_first) <= *mid, and [new_last, last) >= *(mid - 1).
+    first = std::upper_bound(first, mid, *mid, comp);
+    last = std::lower_bound(mid, last, *(mid - 1), comp);
+
+    std::size_t left_len = std::size_t(mid - first);
+    std::size_t right_len = std::size_t(last - mid);
+
+    if (buffer != nullptr) {
+        if (left_len <= right_len) {
+            if (left_len <= buffer_size) {
+                merge_with_buffer_forward(first, mid, last, buffer, comp);
+                return;
+            }
+        } else {
+            if (right_len <= buffer_size) {
+                merge_with_buffer_backward(first, mid, last, buffer, comp);
+                return;
+            }
+        }
+    }
+
+    // After trimming, if one side has only one element, the whole range
+    // of the other side must be moved over it: it's just a rotation.
+    if (left_len == 1 || right_len == 1) {
+        jstd::simd::rotate(first, mid, last);
+        return;
+    }
+
+    std::ptrdiff_t m = std::ptrdiff_t(left_len);
+    std::ptrdiff_t b = std::ptrdiff_t(left_len + right_len);
+    std::ptrdiff_t h = b / 2;
+    std::ptrdiff_t n = h + m;
+
+    std::ptrdiff_t start, r;
+    if (m > h) {
+        start = n - b;
+        r = h;
+    } else {
+        start = 0;
+        r = m;
+    }
+
+    // Binary search the symmetric split point around the center h.
+    std::ptrdiff_t p = n - 1;
+    while (start < r) {
+        std::ptrdiff_t c = start + (r - start) / 2;
+        if (!comp(first[p - c], first[c]))
+            start = c + 1;
+        else
+            r = c;
+    }
+
+    std::ptrdiff_t end = n - start;
+    if (start < m && m < end) {
+        jstd::simd::rotate(first + start, first + m, first + end);
+    }
+
+    if (0 < start && start < h) {
+        sym_merge_impl(first, first + start, first + h, buffer, buffer_size, comp);
+    }
+    if (h < end && end < b) {
+        sym_merge_impl(first + h, first + end, first + b, buffer, buffer_size, comp);
+    }
+}
+
+template <typename T, typename Compare>
+inline
+void inplace_merge_impl(T * first, T * mid, T * last,
+                        T * buffer, std::size_t buffer_size, Compare & comp,
+                        std::true_type /* is_trivially_copyable */)
+{
+    JSTD_ASSERT_EX((first <= mid), "jstd::inplace_merge(): Error, first > mid.");
+    JSTD_ASSERT_EX((mid <= last), "jstd::inplace_merge(): Error, mid > last.");
+
+    sym_merge_impl(first, mid, last, buffer, buffer_size, comp);
+}
+
+template <typename T, typename Compare>
+inline
+void inplace_merge_impl(T * first, T * mid, T * last,
+                        T * buffer, std::size_t buffer_size, Compare & comp,
+                        std::false_type /* is_trivially_copyable */)
+{
+    // The SIMD rotate and the memcpy() of buffer merge need a trivially copyable type.
+    std::inplace_merge(first, mid, last, comp);
+}
+
+} // namespace detail
+
+template <typename T, typename Compare>
+inline
+void inplace_merge(T * first, T * mid, T * last,
+                   T * buffer, std::size_t buffer_size, Compare comp)
+{
+    detail::inplace_merge_impl(first, mid, last, buffer, buffer_size, comp,
+                               std::integral_constant<bool, std::is_trivially_copyable<T>::value>());
+}
+
+template <typename T>
+inline
+void inplace_merge(T * first, T * mid, T * last, T * buffer, std::size_t buffer_size)
+{
+    jstd::inplace_merge(first, mid, last, buffer, buffer_size, std::less<T>());
+}
+
+template <typename T, typename Compare>
+inline
+void inplace_merge(T * first, T * mid, T * last, Compare comp)
+{
+    jstd::inplace_merge(first, mid, last, (T *)nullptr, 0, comp);
+}
+
+template <typename T>
+inline
+void inplace_merge(T * first, T * mid, T * last)
+{
+    jstd::inplace_merge(first, mid, last, (T *)nullptr, 0, std::less<T>());
+}
+
+} // namespace jstd
+
+#endif // JSTD_INPLACE_MERGE_H
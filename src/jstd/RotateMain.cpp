@@ -26,6 +26,9 @@
 #include "jstd/ArrayRotate.h"
 #include "jstd/ArrayRotate_v1.h"
 #include "jstd/ArrayRotate_SIMD.h"
+#include "jstd/VmRingBuffer.h"
+#include "jstd/InplaceMerge.h"
+#include "jstd/StablePartition.h"
 
 static const char dict_str[] =
     "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz+="
@@ -347,6 +350,235 @@ void simd_rotate_test()
     printf("-----------------------------------------------------\n");
 }
 
+void vm_ring_buffer_test()
+{
+    printf("-----------------------------------------------------\n");
+
+    jstd::vm_ring_buffer<int> ring(1000);
+    if (!ring.is_valid()) {
+        printf("jstd::vm_ring_buffer<int>: create failed, skip.\n\n");
+        return;
+    }
+
+    std::size_t length = ring.capacity();
+    std::vector<int> array_std(length);
+    for (size_t i = 0; i < length; i++) {
+        array_std[i] = (int)i;
+        ring.storage()[i] = (int)i;
+    }
+
+    static const std::size_t offsets[] = { 1, 33, 7, 1000, 4095 };
+    int error_pos = -1;
+    for (size_t n = 0; n < sizeof(offsets) / sizeof(offsets[0]); n++) {
+        std::size_t offset = offsets[n] % length;
+        std::rotate(array_std.begin(), array_std.begin() + offset, array_std.end());
+        ring.rotate(offset);
+
+        std::vector<int> window(ring.begin(), ring.end());
+        error_pos = verify_array(window, array_std);
+        if (error_pos != -1)
+            break;
+    }
+
+    printf("jstd::vm_ring_buffer<int>::rotate(%u): ", (uint32_t)length);
+    if (error_pos == -1)
+        printf("Pass");
+    else
+        printf("Failed (pos = %d)", error_pos);
+    printf("\n");
+
+    ring.canonicalize();
+    std::vector<int> canonical(ring.storage(), ring.storage() + length);
+    error_pos = verify_array(canonical, array_std);
+
+    printf("jstd::vm_ring_buffer<int>::canonicalize(%u): ", (uint32_t)length);
+    if (error_pos == -1)
+        printf("Pass");
+    else
+        printf("Failed (pos = %d)", error_pos);
+    printf("\n\n");
+}
+
+struct merge_key_less {
+    // Only compare the high bits, the low 8 bits are the sequence number for the stability check.
+    bool operator () (int a, int b) const {
+        return ((a >> 8) < (b >> 8));
+    }
+};
+
+void inplace_merge_test()
+{
+    printf("-----------------------------------------------------\n");
+
+    static const std::size_t lengths[] = { 2, 33, 100, 1000, 4096, 100000 };
+    static const std::size_t kBufferSize = 256;
+
+    std::vector<int> buffer(kBufferSize);
+    srand(1000);
+
+    for (size_t n = 0; n < sizeof(lengths) / sizeof(lengths[0]); n++) {
+        std::size_t length = lengths[n];
+        int error_pos = -1;
+        int error_pos_buf = -1;
+        for (size_t round = 0; round < 8; round++) {
+            std::size_t left_len = (round == 0) ? 1 : ((round == 1) ? (length - 1) : (next_random_u32() % length));
+            std::vector<int> array_std(length);
+            // Small key range to produce a lot of equal keys.
+            uint32_t key_range = (round & 1) ? 16 : (uint32_t)length;
+            for (size_t i = 0; i < length; i++) {
+                array_std[i] = (int)(((next_random_u32() % key_range) << 8) | (i & 0xFF));
+            }
+            std::sort(array_std.begin(), array_std.begin() + left_len, merge_key_less());
+            std::sort(array_std.begin() + left_len, array_std.end(), merge_key_less());
+
+            std::vector<int> array(array_std);
+            std::vector<int> array_buf(array_std);
+
+            std::inplace_merge(array_std.begin(), array_std.begin() + left_len, array_std.end(), merge_key_less());
+            jstd::inplace_merge(&array[0], &array[0] + left_len, &array[0] + length, merge_key_less());
+            jstd::inplace_merge(&array_buf[0], &array_buf[0] + left_len, &array_buf[0] + length,
+                                &buffer[0], kBufferSize, merge_key_less());
+
+            if (error_pos == -1)
+                error_pos = verify_array(array, array_std);
+            if (error_pos_buf == -1)
+                error_pos_buf = verify_array(array_buf, array_std);
+        }
+
+        printf("jstd::inplace_merge(%u): ", (uint32_t)length);
+        if (error_pos == -1)
+            printf("Pass");
+        else
+            printf("Failed (pos = %d)", error_pos);
+        printf(", with buffer: ");
+        if (error_pos_buf == -1)
+            printf("Pass");
+        else
+            printf("Failed (pos = %d)", error_pos_buf);
+        printf("\n");
+    }
+    printf("\n");
+}
+
+struct odd_key_pred {
+    bool operator () (int x) const {
+        return (((x >> 8) & 1) != 0);
+    }
+};
+
+template <typename T, typename Predicate>
+int stable_partition_verify(std::vector<T> & array_std, Predicate pred)
+{
+    std::vector<T> array(array_std);
+
+    auto iter_std = std::stable_partition(array_std.begin(), array_std.end(), pred);
+    T * iter = jstd::stable_partition(&array[0], &array[0] + array.size(), pred);
+
+    int error_pos = verify_array(array, array_std);
+    if (error_pos == -1 && (iter - &array[0]) != (iter_std - array_std.begin()))
+        error_pos = (int)(iter - &array[0]);
+    return error_pos;
+}
+
+void stable_partition_test()
+{
+    printf("-----------------------------------------------------\n");
+
+    static const std::size_t lengths[] = { 1, 33, 1000, 4096, 100000 };
+    srand(2000);
+
+    for (size_t n = 0; n < sizeof(lengths) / sizeof(lengths[0]); n++) {
+        std::size_t length = lengths[n];
+        int error_pos = -1;
+
+        std::vector<int> array_int(length);
+        std::vector<double> array_double(length);
+        for (size_t i = 0; i < length; i++) {
+            array_int[i] = (int)(((next_random_u32() % 1024) << 8) | (i & 0xFF));
+            array_double[i] = (double)(next_random_u32() % 1000) / 10.0;
+        }
+
+        if (error_pos == -1)
+            error_pos = stable_partition_verify(array_int, odd_key_pred());
+        if (error_pos == -1)
+            error_pos = stable_partition_verify(array_int, jstd::predicate::less_than<int>(512 << 8));
+        if (error_pos == -1)
+            error_pos = stable_partition_verify(array_int, jstd::predicate::equal_to<int>(array_int[0]));
+        if (error_pos == -1)
+            error_pos = stable_partition_verify(array_double, jstd::predicate::greater_than<double>(50.0));
+
+        printf("jstd::stable_partition(%u): ", (uint32_t)length);
+        if (error_pos == -1)
+            printf("Pass");
+        else
+            printf("Failed (pos = %d)", error_pos);
+        printf("\n");
+    }
+    printf("\n");
+}
+
+struct uint128_item {
+    uint64_t low;
+    uint64_t high;
+
+    bool operator != (const uint128_item & rhs) const {
+        return (this->low != rhs.low || this->high != rhs.high);
+    }
+};
+
+template <typename T>
+int simd_reverse_verify(std::size_t max_length)
+{
+    for (size_t length = 0; length <= max_length; length++) {
+        std::vector<T> array_std(length), array(length);
+        for (size_t i = 0; i < length; i++) {
+            std::memset(&array_std[i], (int)(i & 0xFF), sizeof(T));
+            std::memset(&array[i], (int)(i & 0xFF), sizeof(T));
+        }
+        // Misaligned head
+        if (length > 1) {
+            std::reverse(&array_std[0] + 1, &array_std[0] + length);
+            jstd::simd::reverse(&array[0] + 1, &array[0] + length);
+        }
+        int error_pos = verify_array(array, array_std);
+        if (error_pos != -1)
+            return error_pos;
+
+        std::size_t offset = length / 3;
+        std::rotate(array_std.begin(), array_std.begin() + offset, array_std.end());
+        if (length > 0)
+            jstd::simd::rotate_reversal(&array[0], &array[0] + offset, &array[0] + length);
+        error_pos = verify_array(array, array_std);
+        if (error_pos != -1)
+            return error_pos;
+    }
+    return -1;
+}
+
+void simd_reverse_test()
+{
+    printf("-----------------------------------------------------\n");
+
+    static const std::size_t kMaxLength = 300;
+    int error_pos[5];
+    error_pos[0] = simd_reverse_verify<uint8_t>(kMaxLength);
+    error_pos[1] = simd_reverse_verify<uint16_t>(kMaxLength);
+    error_pos[2] = simd_reverse_verify<uint32_t>(kMaxLength);
+    error_pos[3] = simd_reverse_verify<uint64_t>(kMaxLength);
+    error_pos[4] = simd_reverse_verify<uint128_item>(kMaxLength);
+
+    static const std::size_t value_sizes[5] = { 1, 2, 4, 8, 16 };
+    for (size_t i = 0; i < 5; i++) {
+        printf("jstd::simd::reverse<%u bytes>(0 - %u): ", (uint32_t)value_sizes[i], (uint32_t)kMaxLength);
+        if (error_pos[i] == -1)
+            printf("Pass");
+        else
+            printf("Failed (pos = %d)", error_pos[i]);
+        printf("\n");
+    }
+    printf("\n");
+}
+
 void fast_div_verify_fast()
 {
     printf("fast_div_verify_fast():\n\n");
@@ -580,6 +812,85 @@ void fast_mod_verify()
     printf("\n\n");
 }
 
+//
+// The 64-bit divider and modulus against the hardware division, at the edges:
+// the small values, the multiples of d around 2^32, 2^63 and the largest one,
+// the max values, 64 consecutive values around each edge, for all the divisors
+// below 4096, the powers of 2 (and +/- 1, x3), and some pseudo-random divisors.
+//
+static uint32_t fast_div_u64_verify_divisor(uint64_t d, uint64_t & values)
+{
+    static const int kWindow = 32;
+    uint32_t errors = 0;
+    jstd::FastDivider64 divider(d);
+    jstd::FastModulus64 modulus(d);
+
+    const uint64_t kMaxValue = 0xFFFFFFFFFFFFFFFFull;
+    uint64_t edges[] = {
+        0, d, d * 2,
+        (0x100000000ull / d) * d,
+        (0x8000000000000000ull / d) * d,
+        (kMaxValue / d) * d,
+        kMaxValue - kWindow
+    };
+
+    for (size_t e = 0; e < sizeof(edges) / sizeof(edges[0]); e++) {
+        uint64_t first = (edges[e] >= (uint64_t)kWindow) ? (edges[e] - kWindow) : 0;
+        uint64_t last = (edges[e] <= kMaxValue - kWindow) ? (edges[e] + kWindow) : kMaxValue;
+        for (uint64_t n = first; ; n++) {
+            uint64_t q0 = n / d, r0 = n % d;
+            if (divider.divide(n) != q0 || divider.modulus(n) != r0 ||
+                jstd::fast_div_u64(n, d) != q0 || jstd::fast_mod_u64(n, d) != r0 ||
+                modulus.modulus(n) != r0) {
+                if (errors < 4) {
+                    printf("  Failed: d = 0x%016" PRIX64 ", n = 0x%016" PRIX64 ", "
+                           "q = %" PRIu64 " (%" PRIu64 "), r = %" PRIu64 " (%" PRIu64 ")\n",
+                           d, n, divider.divide(n), q0, modulus.modulus(n), r0);
+                }
+                errors++;
+            }
+            values++;
+            if (n == last)
+                break;
+        }
+    }
+    return errors;
+}
+
+void fast_div_u64_verify()
+{
+    uint64_t divisors = 0, values = 0;
+    uint32_t errors = 0;
+
+    for (uint64_t d = 1; d < 4096; d++) {
+        errors += fast_div_u64_verify_divisor(d, values);
+        divisors++;
+    }
+    for (uint32_t k = 12; k < 64; k++) {
+        uint64_t power2 = 1ull << k;
+        errors += fast_div_u64_verify_divisor(power2 - 1, values);
+        errors += fast_div_u64_verify_divisor(power2, values);
+        errors += fast_div_u64_verify_divisor(power2 + 1, values);
+        divisors += 3;
+        if (k < 62) {
+            errors += fast_div_u64_verify_divisor(power2 * 3, values);
+            divisors++;
+        }
+    }
+    uint64_t seed = 0x2545F4914F6CDD1Dull;
+    for (uint32_t i = 0; i < 4096; i++) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        uint64_t d = seed >> (i % 64);
+        if (d != 0) {
+            errors += fast_div_u64_verify_divisor(d, values);
+            divisors++;
+        }
+    }
+
+    printf("fast_div_u64_verify(): %" PRIu64 " divisors, %" PRIu64 " values, %s\n\n",
+           divisors, values, ((errors == 0) ? "Passed" : "Failed"));
+}
+
 int main(int argn, char * argv[])
 {
 #if 0
@@ -590,6 +901,11 @@ int main(int argn, char * argv[])
 #if 1
     rotate_test();
     rotate_unit_test();
+    vm_ring_buffer_test();
+    inplace_merge_test();
+    stable_partition_test();
+    simd_reverse_test();
+    fast_div_u64_verify();
 
     //fast_mod_verify();
 
@@ -0,0 +1,67 @@
+
+#ifndef JSTD_ROTATE_PROBES_H
+#define JSTD_ROTATE_PROBES_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+//
+// USDT (user statically-defined tracing) probes of the rotations.
+//
+// If <sys/sdt.h> is available (systemtap-sdt-dev / systemtap-sdt-devel), each probe
+// is a single nop and a note in the .note.stapsdt section, nothing runs until
+// a tracer attaches to it. Build with -DROTATE_USE_USDT=0 to remove them.
+//
+// Provider: jstd
+//
+//   rotate_entry        (length, offset, elem_size)         jstd::rotate(), the random
+//   rotate_exit         (length, offset, elem_size)         access iterators only
+//   simd_rotate_entry   (length, offset, elem_size)         jstd::simd::rotate()
+//   simd_rotate_exit    (length, offset, elem_size, path)   path: jstd::simd::RotatePath
+//   simd_move_entry     (bytes, stash_regs)                 the forward move loop of
+//   simd_move_exit      (bytes, stash_regs)                 the stash paths
+//
+// The length and offset are in elements, the path names are in RotateStats.h,
+// stash_regs is the N of left_rotate_avx_N_regs() (0: left_rotate_sse_1_regs()).
+// The empty rotations of jstd::simd::rotate() (offset = 0 or offset >= length)
+// are not probed.
+//
+//   bpftrace -e 'usdt:./benchmark:jstd:simd_rotate_entry { @bytes = hist(arg0 * arg2); }'
+//   perf probe -x ./benchmark sdt_jstd:simd_rotate_exit
+//
+
+#ifndef ROTATE_USE_USDT
+#define ROTATE_USE_USDT     1
+#endif
+
+#if ROTATE_USE_USDT && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define JSTD_HAVE_USDT      1
+#endif
+#endif
+
+#ifndef JSTD_HAVE_USDT
+#define JSTD_HAVE_USDT      0
+#endif
+
+#if JSTD_HAVE_USDT
+
+#define JSTD_ROTATE_PROBE2(name, a1, a2) \
+    DTRACE_PROBE2(jstd, name, a1, a2)
+#define JSTD_ROTATE_PROBE3(name, a1, a2, a3) \
+    DTRACE_PROBE3(jstd, name, a1, a2, a3)
+#define JSTD_ROTATE_PROBE4(name, a1, a2, a3, a4) \
+    DTRACE_PROBE4(jstd, name, a1, a2, a3, a4)
+
+#else
+
+// The arguments are not evaluated.
+#define JSTD_ROTATE_PROBE2(name, a1, a2)            ((void)0)
+#define JSTD_ROTATE_PROBE3(name, a1, a2, a3)        ((void)0)
+#define JSTD_ROTATE_PROBE4(name, a1, a2, a3, a4)    ((void)0)
+
+#endif // JSTD_HAVE_USDT
+
+#endif // JSTD_ROTATE_PROBES_H
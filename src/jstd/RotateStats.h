@@ -0,0 +1,297 @@
+
+#ifndef JSTD_ROTATE_STATS_H
+#define JSTD_ROTATE_STATS_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+
+#include "jstd/BitUtils.h"
+
+//
+// The dispatch path counters of jstd::simd::rotate().
+//
+// For each path of left_rotate_avx_impl(): the calls, the bytes moved and
+// a log2 histogram of the bytes moved (bucket n: [2^n, 2^(n+1)) bytes).
+//
+// Build with -DROTATE_USE_STATS=1 to enable them, otherwise JSTD_ROTATE_STATS()
+// is compiled out to nothing and there is no overhead at all.
+//
+// Each thread counts into its own cache line aligned blocks (no lock, no atomic
+// RMW, only relaxed loads and stores), the snapshot sums all the threads, the
+// threads have exited are kept. reset_rotate_stats() doesn't clear the counters
+// of the other threads, it saves the current totals as the base of the next
+// snapshots, so it's safe while the other threads are rotating.
+//
+//   jstd::simd::reset_rotate_stats();
+//   ... workload ...
+//   jstd::simd::RotateStatsSnapshot snapshot;
+//   jstd::simd::get_rotate_stats(snapshot);
+//   jstd::simd::print_rotate_stats(snapshot);
+//
+
+#ifndef ROTATE_USE_STATS
+#define ROTATE_USE_STATS    0
+#endif
+
+#if ROTATE_USE_STATS
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+#endif
+
+namespace jstd {
+namespace simd {
+
+enum RotatePath {
+    RotatePathSmall,            // length * sizeof(T) <= kAVXRotateThresholdBytes
+    RotatePathSSE1,             // left_rotate_sse_1_regs()
+    RotatePathAVX1,             // left_rotate_avx_N_regs<T, 1>() ... <T, 12>()
+    RotatePathAVX12 = RotatePathAVX1 + 11,
+    RotatePathLeftSimple,       // the left stash is too big: left_rotate_simple_impl()
+    RotatePathRightSimple,      // right_rotate_simple_impl()
+    RotatePathGeneric,          // not trivially copyable: left_rotate_simple_impl()
+    RotatePathLast
+};
+
+static const std::size_t kRotateStatsBuckets = 48;
+
+static inline
+const char * rotate_path_name(int path)
+{
+    static const char * const kRotatePathNames[RotatePathLast] = {
+        "small", "sse_1",
+        "avx_1", "avx_2", "avx_3", "avx_4", "avx_5", "avx_6",
+        "avx_7", "avx_8", "avx_9", "avx_10", "avx_11", "avx_12",
+        "left_simple", "right_simple", "generic"
+    };
+    return ((path >= 0 && path < RotatePathLast) ? kRotatePathNames[path] : "unknown");
+}
+
+// floor(log2(bytes)), the last bucket also counts the bigger sizes.
+static inline
+std::size_t rotate_stats_bucket(std::size_t bytes)
+{
+    if (bytes <= 1)
+        return 0;
+    std::size_t bucket = (std::size_t)BitUtils::bsr(bytes);
+    return ((bucket < kRotateStatsBuckets) ? bucket : (kRotateStatsBuckets - 1));
+}
+
+struct RotateStatsSnapshot {
+    std::uint64_t   calls[RotatePathLast];
+    std::uint64_t   bytes[RotatePathLast];
+    std::uint64_t   histogram[RotatePathLast][kRotateStatsBuckets];
+
+    RotateStatsSnapshot() {
+        this->clear();
+    }
+
+    void clear() {
+        for (int path = 0; path < RotatePathLast; path++) {
+            this->calls[path] = 0;
+            this->bytes[path] = 0;
+            for (std::size_t bucket = 0; bucket < kRotateStatsBuckets; bucket++) {
+                this->histogram[path][bucket] = 0;
+            }
+        }
+    }
+
+    std::uint64_t total_calls() const {
+        std::uint64_t total = 0;
+        for (int path = 0; path < RotatePathLast; path++) {
+            total += this->calls[path];
+        }
+        return total;
+    }
+};
+
+#if ROTATE_USE_STATS
+
+struct alignas(64) RotatePathCounters {
+    std::atomic<std::uint64_t>  calls;
+    std::atomic<std::uint64_t>  bytes;
+    std::atomic<std::uint64_t>  histogram[kRotateStatsBuckets];
+
+    RotatePathCounters() : calls(0), bytes(0) {
+        for (std::size_t bucket = 0; bucket < kRotateStatsBuckets; bucket++) {
+            this->histogram[bucket].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // Only the owner thread writes, a load and a store is enough (no lock prefix).
+    static void increase(std::atomic<std::uint64_t> & counter, std::uint64_t value) {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    void add(std::size_t _bytes) {
+        increase(this->calls, 1);
+        increase(this->bytes, _bytes);
+        increase(this->histogram[rotate_stats_bucket(_bytes)], 1);
+    }
+
+    void add_to(RotateStatsSnapshot & snapshot, int path) const {
+        snapshot.calls[path] += this->calls.load(std::memory_order_relaxed);
+        snapshot.bytes[path] += this->bytes.load(std::memory_order_relaxed);
+        for (std::size_t bucket = 0; bucket < kRotateStatsBuckets; bucket++) {
+            snapshot.histogram[path][bucket] += this->histogram[bucket].load(std::memory_order_relaxed);
+        }
+    }
+};
+
+struct RotateThreadStats;
+
+class RotateStatsRegistry {
+private:
+    std::mutex                          mutex_;
+    std::vector<RotateThreadStats *>    threads_;
+    RotateStatsSnapshot                 retired_;
+    RotateStatsSnapshot                 base_;
+
+public:
+    static RotateStatsRegistry & instance() {
+        static RotateStatsRegistry s_registry;
+        return s_registry;
+    }
+
+    inline void add_thread(RotateThreadStats * stats);
+    inline void remove_thread(RotateThreadStats * stats);
+    inline void get_totals(RotateStatsSnapshot & snapshot);
+    inline void snapshot(RotateStatsSnapshot & snapshot);
+    inline void reset();
+};
+
+struct RotateThreadStats {
+    RotatePathCounters  paths[RotatePathLast];
+
+    RotateThreadStats() {
+        RotateStatsRegistry::instance().add_thread(this);
+    }
+
+    ~RotateThreadStats() {
+        RotateStatsRegistry::instance().remove_thread(this);
+    }
+
+    void add_to(RotateStatsSnapshot & snapshot) const {
+        for (int path = 0; path < RotatePathLast; path++) {
+            this->paths[path].add_to(snapshot, path);
+        }
+    }
+};
+
+void RotateStatsRegistry::add_thread(RotateThreadStats * stats) {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->threads_.push_back(stats);
+}
+
+void RotateStatsRegistry::remove_thread(RotateThreadStats * stats) {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    stats->add_to(this->retired_);
+    this->threads_.erase(std::remove(this->threads_.begin(), this->threads_.end(), stats),
+                         this->threads_.end());
+}
+
+// The totals since the start, the mutex must be locked.
+void RotateStatsRegistry::get_totals(RotateStatsSnapshot & snapshot) {
+    snapshot = this->retired_;
+    for (std::size_t i = 0; i < this->threads_.size(); i++) {
+        this->threads_[i]->add_to(snapshot);
+    }
+}
+
+void RotateStatsRegistry::snapshot(RotateStatsSnapshot & snapshot) {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->get_totals(snapshot);
+    for (int path = 0; path < RotatePathLast; path++) {
+        snapshot.calls[path] -= this->base_.calls[path];
+        snapshot.bytes[path] -= this->base_.bytes[path];
+        for (std::size_t bucket = 0; bucket < kRotateStatsBuckets; bucket++) {
+            snapshot.histogram[path][bucket] -= this->base_.histogram[path][bucket];
+        }
+    }
+}
+
+void RotateStatsRegistry::reset() {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->get_totals(this->base_);
+}
+
+// Not static, so a thread has only one block in all the translation units.
+inline
+RotateThreadStats & get_rotate_thread_stats()
+{
+    static thread_local RotateThreadStats s_stats;
+    return s_stats;
+}
+
+static inline
+void count_rotate_path(int path, std::size_t bytes)
+{
+    get_rotate_thread_stats().paths[path].add(bytes);
+}
+
+static inline
+void get_rotate_stats(RotateStatsSnapshot & snapshot)
+{
+    RotateStatsRegistry::instance().snapshot(snapshot);
+}
+
+static inline
+void reset_rotate_stats()
+{
+    RotateStatsRegistry::instance().reset();
+}
+
+#define JSTD_ROTATE_STATS(path, bytes)  jstd::simd::count_rotate_path((path), (bytes))
+
+#else // !ROTATE_USE_STATS
+
+static inline
+void get_rotate_stats(RotateStatsSnapshot & snapshot)
+{
+    snapshot.clear();
+}
+
+static inline
+void reset_rotate_stats()
+{
+}
+
+#define JSTD_ROTATE_STATS(path, bytes)  ((void)0)
+
+#endif // ROTATE_USE_STATS
+
+//
+// Print the calls and the bytes of each path, and its non-empty histogram buckets.
+//
+static inline
+void print_rotate_stats(const RotateStatsSnapshot & snapshot, std::FILE * fp = stdout)
+{
+    std::uint64_t total_calls = snapshot.total_calls();
+    std::fprintf(fp, " %-14s %14s %8s %18s\n", "path", "calls", "%", "bytes");
+    for (int path = 0; path < RotatePathLast; path++) {
+        if (snapshot.calls[path] == 0)
+            continue;
+        std::fprintf(fp, " %-14s %14llu %7.2f%% %18llu\n", rotate_path_name(path),
+                     (unsigned long long)snapshot.calls[path],
+                     (total_calls != 0) ? ((double)snapshot.calls[path] * 100.0 / (double)total_calls) : 0.0,
+                     (unsigned long long)snapshot.bytes[path]);
+        for (std::size_t bucket = 0; bucket < kRotateStatsBuckets; bucket++) {
+            if (snapshot.histogram[path][bucket] != 0) {
+                std::fprintf(fp, "   [2^%-2u, 2^%-2u) %12llu\n", (unsigned)bucket, (unsigned)(bucket + 1),
+                             (unsigned long long)snapshot.histogram[path][bucket]);
+            }
+        }
+    }
+    std::fprintf(fp, "\n");
+}
+
+} // namespace simd
+} // namespace jstd
+
+#endif // JSTD_ROTATE_STATS_H
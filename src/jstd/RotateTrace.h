@@ -0,0 +1,211 @@
+
+#ifndef JSTD_ROTATE_TRACE_H
+#define JSTD_ROTATE_TRACE_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdbool>
+#include <cstdio>
+#include <cstring>
+
+#include "jstd/stddef.h"
+
+//
+// The binary trace of the rotations, to record the real workload and replay it
+// (see src/replay/RotateReplay.cpp).
+//
+// File layout (little endian):
+//
+//   RotateTraceHeader       24 bytes: magic "JRTRACE", version, record size, count
+//   RotateTraceRecord [N]   24 bytes each: length, offset, sizeof(T), alignment
+//
+// alignment is the address of first modulo 64. If the writer was not closed
+// (e.g. the process was killed), count is 0 and the reader reads until EOF.
+//
+// Record in the production code:
+//
+//   jstd::RotateTraceWriter trace;
+//   trace.open("rotate.trace");
+//   ...
+//   trace.record(first, mid, last);
+//   jstd::simd::rotate(first, mid, last);
+//
+// The writer is not thread safe, use one writer per thread (one file per thread).
+//
+
+namespace jstd {
+
+static const char          kRotateTraceMagic[8] = { 'J', 'R', 'T', 'R', 'A', 'C', 'E', '\0' };
+static const std::uint32_t kRotateTraceVersion = 1;
+static const std::uint32_t kRotateTraceAlignment = 64;
+
+#pragma pack(push, 1)
+
+struct RotateTraceHeader {
+    char            magic[8];
+    std::uint32_t   version;
+    std::uint32_t   record_size;
+    std::uint64_t   count;
+};
+
+struct RotateTraceRecord {
+    std::uint64_t   length;
+    std::uint64_t   offset;
+    std::uint32_t   elem_size;
+    std::uint32_t   alignment;
+};
+
+#pragma pack(pop)
+
+JSTD_STATIC_ASSERT((sizeof(RotateTraceHeader) == 24), "RotateTraceHeader: the size must be 24 bytes.");
+JSTD_STATIC_ASSERT((sizeof(RotateTraceRecord) == 24), "RotateTraceRecord: the size must be 24 bytes.");
+
+class RotateTraceWriter {
+private:
+    std::FILE *     fp_;
+    std::uint64_t   count_;
+
+public:
+    RotateTraceWriter() : fp_(nullptr), count_(0) {}
+
+    ~RotateTraceWriter() {
+        this->close();
+    }
+
+    bool is_open() const { return (this->fp_ != nullptr); }
+
+    std::uint64_t count() const { return this->count_; }
+
+    bool open(const char * filename) {
+        this->close();
+        this->fp_ = std::fopen(filename, "wb");
+        if (this->fp_ == nullptr)
+            return false;
+        this->count_ = 0;
+        // The count is written by close().
+        return this->write_header(0);
+    }
+
+    void close() {
+        if (this->fp_ != nullptr) {
+            std::fflush(this->fp_);
+            if (std::fseek(this->fp_, 0, SEEK_SET) == 0) {
+                this->write_header(this->count_);
+            }
+            std::fclose(this->fp_);
+            this->fp_ = nullptr;
+        }
+    }
+
+    bool append(std::uint64_t length, std::uint64_t offset,
+                std::uint32_t elem_size, std::uint32_t alignment) {
+        if (this->fp_ == nullptr)
+            return false;
+        RotateTraceRecord record;
+        record.length = length;
+        record.offset = offset;
+        record.elem_size = elem_size;
+        record.alignment = alignment % kRotateTraceAlignment;
+        if (std::fwrite(&record, sizeof(record), 1, this->fp_) != 1)
+            return false;
+        this->count_++;
+        return true;
+    }
+
+    template <typename T>
+    bool record(T * first, T * mid, T * last) {
+        return this->append((std::uint64_t)(last - first), (std::uint64_t)(mid - first),
+                            (std::uint32_t)sizeof(T),
+                            (std::uint32_t)((std::size_t)first % kRotateTraceAlignment));
+    }
+
+private:
+    bool write_header(std::uint64_t count) {
+        RotateTraceHeader header;
+        std::memcpy(header.magic, kRotateTraceMagic, sizeof(header.magic));
+        header.version = kRotateTraceVersion;
+        header.record_size = (std::uint32_t)sizeof(RotateTraceRecord);
+        header.count = count;
+        return (std::fwrite(&header, sizeof(header), 1, this->fp_) == 1);
+    }
+
+    RotateTraceWriter(const RotateTraceWriter & src) = delete;
+    RotateTraceWriter & operator = (const RotateTraceWriter & rhs) = delete;
+};
+
+class RotateTraceReader {
+private:
+    std::FILE *     fp_;
+    std::uint64_t   count_;
+    std::uint64_t   index_;
+    std::uint32_t   record_size_;
+
+public:
+    RotateTraceReader() : fp_(nullptr), count_(0), index_(0), record_size_(0) {}
+
+    ~RotateTraceReader() {
+        this->close();
+    }
+
+    bool is_open() const { return (this->fp_ != nullptr); }
+
+    // 0 if unknown (the writer was not closed).
+    std::uint64_t count() const { return this->count_; }
+
+    // Returns false if the file can't be opened or it's not a rotate trace.
+    bool open(const char * filename) {
+        this->close();
+        this->fp_ = std::fopen(filename, "rb");
+        if (this->fp_ == nullptr)
+            return false;
+
+        RotateTraceHeader header;
+        if (std::fread(&header, sizeof(header), 1, this->fp_) != 1 ||
+            std::memcmp(header.magic, kRotateTraceMagic, sizeof(header.magic)) != 0 ||
+            header.version != kRotateTraceVersion ||
+            header.record_size < sizeof(RotateTraceRecord)) {
+            this->close();
+            return false;
+        }
+        this->count_ = header.count;
+        this->index_ = 0;
+        this->record_size_ = header.record_size;
+        return true;
+    }
+
+    void close() {
+        if (this->fp_ != nullptr) {
+            std::fclose(this->fp_);
+            this->fp_ = nullptr;
+        }
+    }
+
+    // Returns false at the end of the trace.
+    bool next(RotateTraceRecord & record) {
+        if (this->fp_ == nullptr)
+            return false;
+        if (this->count_ != 0 && this->index_ >= this->count_)
+            return false;
+        if (std::fread(&record, sizeof(record), 1, this->fp_) != 1)
+            return false;
+        // Skip the fields of the newer versions.
+        if (this->record_size_ > sizeof(RotateTraceRecord)) {
+            if (std::fseek(this->fp_, (long)(this->record_size_ - sizeof(RotateTraceRecord)), SEEK_CUR) != 0)
+                return false;
+        }
+        this->index_++;
+        return true;
+    }
+
+private:
+    RotateTraceReader(const RotateTraceReader & src) = delete;
+    RotateTraceReader & operator = (const RotateTraceReader & rhs) = delete;
+};
+
+} // namespace jstd
+
+#endif // JSTD_ROTATE_TRACE_H
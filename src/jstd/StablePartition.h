@@ -0,0 +1,454 @@
+
+#ifndef JSTD_STABLE_PARTITION_H
+#define JSTD_STABLE_PARTITION_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdbool>
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+
+#include "jstd/stddef.h"
+#include "jstd/ArrayRotate_SIMD.h"
+
+//
+// In-place stable partition without any heap allocation.
+//
+// It's the rotation-based divide and conquer (O(n log n)), the same as
+// the fallback of std::stable_partition() when it can't get a buffer,
+// but the combine step uses jstd::simd::rotate(). The leaves of recursion
+// are partitioned with a fixed-size buffer on stack.
+//
+// For the simple predicates on arithmetic types, jstd::predicate::less_than<T>,
+// greater_than<T> and equal_to<T>, the leaves evaluate the predicate with
+// AVX2 compares and movemask, 32 elements per step.
+//
+// See: https://en.cppreference.com/w/cpp/algorithm/stable_partition
+//
+
+namespace jstd {
+namespace predicate {
+
+enum compare_op {
+    kCompareLess,
+    kCompareGreater,
+    kCompareEqual
+};
+
+template <typename T>
+struct less_than {
+    static const int kCompareOp = kCompareLess;
+    T value;
+
+    explicit less_than(T _value) : value(_value) {}
+
+    bool operator () (const T & x) const {
+        return (x < this->value);
+    }
+};
+
+template <typename T>
+struct greater_than {
+    static const int kCompareOp = kCompareGreater;
+    T value;
+
+    explicit greater_than(T _value) : value(_value) {}
+
+    bool operator () (const T & x) const {
+        return (x > this->value);
+    }
+};
+
+template <typename T>
+struct equal_to {
+    static const int kCompareOp = kCompareEqual;
+    T value;
+
+    explicit equal_to(T _value) : value(_value) {}
+
+    bool operator () (const T & x) const {
+        return (x == this->value);
+    }
+};
+
+} // namespace predicate
+
+namespace detail {
+
+//
+// Evaluate the predicate on 32 elements, return the result bit mask.
+//
+template <typename T>
+struct avx_compare {
+    static const bool kSupported = false;
+};
+
+#if defined(__AVX2__)
+
+template <typename Compare, int CompareOp, typename T>
+static JSTD_FORCED_INLINE
+uint32_t avx_compare_mask32(const T * data, const typename Compare::vec_type & value)
+{
+    uint32_t mask = 0;
+    for (std::size_t i = 0; i < Compare::kBlockLen; i += Compare::kLanes) {
+        uint32_t bits = Compare::template mask<CompareOp>(data + i, value);
+        mask |= (bits << i);
+    }
+    return mask;
+}
+
+template <>
+struct avx_compare<int32_t> {
+    typedef __m256i vec_type;
+
+    static const bool kSupported = true;
+    static const std::size_t kLanes = sizeof(vec_type) / sizeof(int32_t);
+    static const std::size_t kBlockLen = 32;
+
+    static JSTD_FORCED_INLINE
+    __m256i broadcast(int32_t value) {
+        return _mm256_set1_epi32(value);
+    }
+
+    template <int CompareOp>
+    static JSTD_FORCED_INLINE
+    uint32_t mask(const int32_t * data, __m256i value) {
+        __m256i x = _mm256_loadu_si256((const __m256i *)data);
+        __m256i result;
+        if (CompareOp == predicate::kCompareLess)
+            result = _mm256_cmpgt_epi32(value, x);
+        else if (CompareOp == predicate::kCompareGreater)
+            result = _mm256_cmpgt_epi32(x, value);
+        else
+            result = _mm256_cmpeq_epi32(x, value);
+        return (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(result));
+    }
+};
+
+template <>
+struct avx_compare<uint32_t> {
+    typedef __m256i vec_type;
+
+    static const bool kSupported = true;
+    static const std::size_t kLanes = sizeof(vec_type) / sizeof(uint32_t);
+    static const std::size_t kBlockLen = 32;
+
+    // Flip the sign bit, then the signed compare is the unsigned compare.
+    static JSTD_FORCED_INLINE
+    __m256i broadcast(uint32_t value) {
+        return _mm256_set1_epi32((int32_t)(value ^ 0x80000000ul));
+    }
+
+    template <int CompareOp>
+    static JSTD_FORCED_INLINE
+    uint32_t mask(const uint32_t * data, __m256i value) {
+        __m256i sign = _mm256_set1_epi32((int32_t)0x80000000ul);
+        __m256i x = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)data), sign);
+        __m256i result;
+        if (CompareOp == predicate::kCompareLess)
+            result = _mm256_cmpgt_epi32(value, x);
+        else if (CompareOp == predicate::kCompareGreater)
+            result = _mm256_cmpgt_epi32(x, value);
+        else
+            result = _mm256_cmpeq_epi32(x, value);
+        return (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(result));
+    }
+};
+
+template <>
+struct avx_compare<int64_t> {
+    typedef __m256i vec_type;
+
+    static const bool kSupported = true;
+    static const std::size_t kLanes = sizeof(vec_type) / sizeof(int64_t);
+    static const std::size_t kBlockLen = 32;
+
+    static JSTD_FORCED_INLINE
+    __m256i broadcast(int64_t value) {
+        return _mm256_set1_epi64x(value);
+    }
+
+    template <int CompareOp>
+    static JSTD_FORCED_INLINE
+    uint32_t mask(const int64_t * data, __m256i value) {
+        __m256i x = _mm256_loadu_si256((const __m256i *)data);
+        __m256i result;
+        if (CompareOp == predicate::kCompareLess)
+            result = _mm256_cmpgt_epi64(value, x);
+        else if (CompareOp == predicate::kCompareGreater)
+            result = _mm256_cmpgt_epi64(x, value);
+        else
+            result = _mm256_cmpeq_epi64(x, value);
+        return (uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(result));
+    }
+};
+
+template <>
+struct avx_compare<uint64_t> {
+    typedef __m256i vec_type;
+
+    static const bool kSupported = true;
+    static const std::size_t kLanes = sizeof(vec_type) / sizeof(uint64_t);
+    static const std::size_t kBlockLen = 32;
+
+    static JSTD_FORCED_INLINE
+    __m256i broadcast(uint64_t value) {
+        return _mm256_set1_epi64x((int64_t)(value ^ 0x8000000000000000ull));
+    }
+
+    template <int CompareOp>
+    static JSTD_FORCED_INLINE
+    uint32_t mask(const uint64_t * data, __m256i value) {
+        __m256i sign = _mm256_set1_epi64x((int64_t)0x8000000000000000ull);
+        __m256i x = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)data), sign);
+        __m256i result;
+        if (CompareOp == predicate::kCompareLess)
+            result = _mm256_cmpgt_epi64(value, x);
+        else if (CompareOp == predicate::kCompareGreater)
+            result = _mm256_cmpgt_epi64(x, value);
+        else
+            result = _mm256_cmpeq_epi64(x, value);
+        return (uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(result));
+    }
+};
+
+template <>
+struct avx_compare<float> {
+    typedef __m256 vec_type;
+
+    static const bool kSupported = true;
+    static const std::size_t kLanes = sizeof(vec_type) / sizeof(float);
+    static const std::size_t kBlockLen = 32;
+
+    static JSTD_FORCED_INLINE
+    __m256 broadcast(float value) {
+        return _mm256_set1_ps(value);
+    }
+
+    // The ordered, non-signaling compares, the same results as the scalar operators on NaN.
+    template <int CompareOp>
+    static JSTD_FORCED_INLINE
+    uint32_t mask(const float * data, __m256 value) {
+        __m256 x = _mm256_loadu_ps(data);
+        __m256 result;
+        if (CompareOp == predicate::kCompareLess)
+            result = _mm256_cmp_ps(x, value, _CMP_LT_OQ);
+        else if (CompareOp == predicate::kCompareGreater)
+            result = _mm256_cmp_ps(x, value, _CMP_GT_OQ);
+        else
+            result = _mm256_cmp_ps(x, value, _CMP_EQ_OQ);
+        return (uint32_t)_mm256_movemask_ps(result);
+    }
+};
+
+template <>
+struct avx_compare<double> {
+    typedef __m256d vec_type;
+
+    static const bool kSupported = true;
+    static const std::size_t kLanes = sizeof(vec_type) / sizeof(double);
+    static const std::size_t kBlockLen = 32;
+
+    static JSTD_FORCED_INLINE
+    __m256d broadcast(double value) {
+        return _mm256_set1_pd(value);
+    }
+
+    template <int CompareOp>
+    static JSTD_FORCED_INLINE
+    uint32_t mask(const double * data, __m256d value) {
+        __m256d x = _mm256_loadu_pd(data);
+        __m256d result;
+        if (CompareOp == predicate::kCompareLess)
+            result = _mm256_cmp_pd(x, value, _CMP_LT_OQ);
+        else if (CompareOp == predicate::kCompareGreater)
+            result = _mm256_cmp_pd(x, value, _CMP_GT_OQ);
+        else
+            result = _mm256_cmp_pd(x, value, _CMP_EQ_OQ);
+        return (uint32_t)_mm256_movemask_pd(result);
+    }
+};
+
+#endif // __AVX2__
+
+template <typename T, typename Predicate>
+struct is_simd_predicate {
+    static const bool value = false;
+};
+
+template <typename T>
+struct is_simd_predicate<T, predicate::less_than<T>> {
+    static const bool value = avx_compare<T>::kSupported;
+};
+
+template <typename T>
+struct is_simd_predicate<T, predicate::greater_than<T>> {
+    static const bool value = avx_compare<T>::kSupported;
+};
+
+template <typename T>
+struct is_simd_predicate<T, predicate::equal_to<T>> {
+    static const bool value = avx_compare<T>::kSupported;
+};
+
+//
+// Partition a small block with the buffer: the true elements are compacted
+// forward in place, the false elements are spilled to the buffer and copied back.
+// Both stores are done unconditionally, only the pointers advance by the result,
+// so there is no branch misprediction on random data.
+//
+template <typename T>
+JSTD_FORCED_INLINE
+void stable_partition_put(T * & dest, T * & spill, const T & value, bool is_true)
+{
+    *dest = value;
+    *spill = value;
+    dest += std::size_t(is_true);
+    spill += std::size_t(!is_true);
+}
+
+template <typename T, typename Predicate>
+inline
+T * stable_partition_block(T * first, T * last, Predicate & pred, T * buffer, std::false_type /* is_simd */)
+{
+    T * dest = first;
+    T * spill = buffer;
+    for (T * iter = first; iter != last; ++iter) {
+        stable_partition_put(dest, spill, *iter, bool(pred(*iter)));
+    }
+    std::memcpy((void *)dest, (const void *)buffer, std::size_t(spill - buffer) * sizeof(T));
+    return dest;
+}
+
+#if defined(__AVX2__)
+
+template <typename T, typename Predicate>
+inline
+T * stable_partition_block(T * first, T * last, Predicate & pred, T * buffer, std::true_type /* is_simd */)
+{
+    typedef avx_compare<T> compare_type;
+    typedef typename compare_type::vec_type vec_type;
+    static const std::size_t kBlockLen = compare_type::kBlockLen;
+
+    vec_type value = compare_type::broadcast(pred.value);
+
+    T * dest = first;
+    T * spill = buffer;
+    T * iter = first;
+    std::size_t length = std::size_t(last - first);
+    T * limit = first + (length - length % kBlockLen);
+    while (iter != limit) {
+        // The mask of the whole block is computed before any store to this block.
+        uint32_t mask = avx_compare_mask32<compare_type, Predicate::kCompareOp>(iter, value);
+        for (std::size_t i = 0; i < kBlockLen; i++) {
+            stable_partition_put(dest, spill, iter[i], bool((mask >> i) & 1u));
+        }
+        iter += kBlockLen;
+    }
+    for (; iter != last; ++iter) {
+        stable_partition_put(dest, spill, *iter, bool(pred(*iter)));
+    }
+    std::memcpy((void *)dest, (const void *)buffer, std::size_t(spill - buffer) * sizeof(T));
+    return dest;
+}
+
+#endif // __AVX2__
+
+template <typename T, typename Predicate, typename IsSimd>
+T * stable_partition_impl(T * first, T * last, Predicate & pred,
+                          T * buffer, std::size_t buffer_len, IsSimd is_simd)
+{
+    std::size_t length = std::size_t(last - first);
+    if (length <= buffer_len) {
+        return stable_partition_block(first, last, pred, buffer, is_simd);
+    }
+    if (length == 1) {
+        return (pred(*first) ? last : first);
+    }
+
+    T * mid = first + length / 2;
+    T * left_last = stable_partition_impl(first, mid, pred, buffer, buffer_len, is_simd);
+    T * right_last = stable_partition_impl(mid, last, pred, buffer, buffer_len, is_simd);
+
+    // [left_last, mid) are false, [mid, right_last) are true, swap them.
+    if (left_last != mid && mid != right_last) {
+        jstd::simd::rotate(left_last, mid, right_last);
+    }
+    return (left_last + (right_last - mid));
+}
+
+template <typename ForwardIterator, typename Predicate>
+ForwardIterator stable_partition_generic(ForwardIterator first, ForwardIterator last,
+                                         Predicate & pred, std::size_t length)
+{
+    if (length == 0)
+        return first;
+    if (length == 1)
+        return (pred(*first) ? std::next(first) : first);
+
+    ForwardIterator mid = std::next(first, length / 2);
+    ForwardIterator left_last = stable_partition_generic(first, mid, pred, length / 2);
+    ForwardIterator right_last = stable_partition_generic(mid, last, pred, length - length / 2);
+    return std::rotate(left_last, mid, right_last);
+}
+
+template <typename T, typename Predicate>
+inline
+T * stable_partition(T * first, T * last, Predicate & pred, std::true_type /* is_trivially_copyable */)
+{
+    // Buffer on stack, the size of leaves.
+    static const std::size_t kStackBufferBytes = 4096;
+    static const std::size_t kBufferLen = (sizeof(T) <= kStackBufferBytes) ? (kStackBufferBytes / sizeof(T)) : 1;
+
+    typedef typename std::aligned_storage<sizeof(T) * kBufferLen, alignof(T)>::type buffer_type;
+    buffer_type stack_buffer;
+    T * buffer = reinterpret_cast<T *>(&stack_buffer);
+    std::size_t buffer_len = (sizeof(T) <= kStackBufferBytes) ? kBufferLen : 0;
+
+    typedef std::integral_constant<bool, is_simd_predicate<T, Predicate>::value> is_simd;
+    return stable_partition_impl(first, last, pred, buffer, buffer_len, is_simd());
+}
+
+template <typename T, typename Predicate>
+inline
+T * stable_partition(T * first, T * last, Predicate & pred, std::false_type /* is_trivially_copyable */)
+{
+    return stable_partition_generic(first, last, pred, std::size_t(last - first));
+}
+
+} // namespace detail
+
+template <typename T, typename Predicate>
+inline
+T * stable_partition(T * first, T * last, Predicate pred)
+{
+    JSTD_ASSERT_EX((first <= last), "jstd::stable_partition(): Error, first > last.");
+
+    // Skip the leading elements that are already in place.
+    while (first != last && pred(*first)) {
+        ++first;
+    }
+    if (first == last)
+        return first;
+
+    return detail::stable_partition(first, last, pred,
+                                    std::integral_constant<bool, std::is_trivially_copyable<T>::value>());
+}
+
+template <typename ForwardIterator, typename Predicate>
+inline
+ForwardIterator stable_partition(ForwardIterator first, ForwardIterator last, Predicate pred)
+{
+    first = std::find_if_not(first, last, pred);
+    std::size_t length = (std::size_t)std::distance(first, last);
+    return detail::stable_partition_generic(first, last, pred, length);
+}
+
+} // namespace jstd
+
+#endif // JSTD_STABLE_PARTITION_H
@@ -0,0 +1,210 @@
+
+#ifndef JSTD_TRACE_SCOPE_H
+#define JSTD_TRACE_SCOPE_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+//
+// Scoped tracing to the Chrome trace event format (chrome://tracing, ui.perfetto.dev).
+//
+//   void pipeline() {
+//       JSTD_TRACE_SCOPE("pipeline");
+//       {
+//           JSTD_TRACE_SCOPE("rotate");
+//           jstd::simd::rotate(first, mid, last);
+//       }
+//       ...
+//   }
+//
+// Build with -DJSTD_USE_TRACE_SCOPE=1 to enable it, otherwise JSTD_TRACE_SCOPE()
+// is compiled out to nothing. The name must be a string literal (only the pointer
+// is stored).
+//
+// Each thread records the complete events ("ph": "X") into its own ring buffer
+// of kTraceBufferEvents events, without any lock, the oldest events are overwritten
+// when it's full. The buffers are written at exit to the file named by the
+// JSTD_TRACE_FILE environment variable (default: jstd_trace.json), or on demand
+// by jstd::trace_flush(filename). Flush when the other threads are not tracing,
+// the events being recorded during a flush may be torn.
+//
+// The timestamps are std::chrono::steady_clock nanoseconds since the first event.
+//
+
+#ifndef JSTD_USE_TRACE_SCOPE
+#define JSTD_USE_TRACE_SCOPE    0
+#endif
+
+#if JSTD_USE_TRACE_SCOPE
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#include "jstd/stddef.h"
+
+namespace jstd {
+
+static const std::size_t kTraceBufferEvents = 64 * 1024;
+
+struct TraceEvent {
+    const char *    name;
+    std::uint64_t   start;      // unit: ns
+    std::uint64_t   duration;   // unit: ns
+};
+
+class TraceBuffer {
+public:
+    TraceEvent                  events[kTraceBufferEvents];
+    std::atomic<std::uint64_t>  head;
+    std::uint32_t               tid;
+
+    explicit TraceBuffer(std::uint32_t _tid) : head(0), tid(_tid) {}
+
+    // Only called by the owner thread.
+    JSTD_FORCED_INLINE
+    void record(const char * name, std::uint64_t start, std::uint64_t duration) {
+        std::uint64_t index = this->head.load(std::memory_order_relaxed);
+        TraceEvent & event = this->events[index & (kTraceBufferEvents - 1)];
+        event.name = name;
+        event.start = start;
+        event.duration = duration;
+        this->head.store(index + 1, std::memory_order_release);
+    }
+};
+
+JSTD_STATIC_ASSERT(((kTraceBufferEvents & (kTraceBufferEvents - 1)) == 0),
+                   "kTraceBufferEvents must be power of 2.");
+
+class TraceRegistry {
+private:
+    std::mutex                  mutex_;
+    std::vector<TraceBuffer *>  buffers_;
+    std::chrono::steady_clock::time_point base_time_;
+
+public:
+    TraceRegistry() : base_time_(std::chrono::steady_clock::now()) {}
+
+    ~TraceRegistry() {
+        const char * filename = std::getenv("JSTD_TRACE_FILE");
+        this->flush((filename != nullptr && filename[0] != '\0') ? filename : "jstd_trace.json");
+        // The buffers are not freed, the other threads may still exit after this.
+    }
+
+    static TraceRegistry & instance() {
+        static TraceRegistry s_registry;
+        return s_registry;
+    }
+
+    std::uint64_t now() const {
+        return (std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - this->base_time_).count();
+    }
+
+    // Called once per thread, at the first event of the thread.
+    TraceBuffer * create_buffer() {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        TraceBuffer * buffer = new TraceBuffer((std::uint32_t)(this->buffers_.size() + 1));
+        this->buffers_.push_back(buffer);
+        return buffer;
+    }
+
+    bool flush(const char * filename) {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        std::FILE * fp = std::fopen(filename, "wb");
+        if (fp == nullptr)
+            return false;
+
+        std::fprintf(fp, "{\"traceEvents\":[\n");
+        bool first_event = true;
+        for (std::size_t n = 0; n < this->buffers_.size(); n++) {
+            const TraceBuffer * buffer = this->buffers_[n];
+            std::uint64_t head = buffer->head.load(std::memory_order_acquire);
+            std::uint64_t count = (head < kTraceBufferEvents) ? head : kTraceBufferEvents;
+            for (std::uint64_t i = head - count; i < head; i++) {
+                const TraceEvent & event = buffer->events[i & (kTraceBufferEvents - 1)];
+                // ts and dur are in microseconds.
+                std::fprintf(fp, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+                                 "\"ts\":%.3f,\"dur\":%.3f}",
+                             (first_event ? "" : ",\n"), event.name, buffer->tid,
+                             (double)event.start / 1000.0, (double)event.duration / 1000.0);
+                first_event = false;
+            }
+        }
+        std::fprintf(fp, "\n],\"displayTimeUnit\":\"ns\"}\n");
+        std::fclose(fp);
+        return true;
+    }
+};
+
+// Not static, so a thread has only one buffer in all the translation units.
+inline
+TraceBuffer * get_trace_buffer()
+{
+    static thread_local TraceBuffer * s_buffer = nullptr;
+    if (unlikely(s_buffer == nullptr))
+        s_buffer = TraceRegistry::instance().create_buffer();
+    return s_buffer;
+}
+
+static inline
+bool trace_flush(const char * filename)
+{
+    return TraceRegistry::instance().flush(filename);
+}
+
+class TraceScope {
+private:
+    const char *    name_;
+    std::uint64_t   start_;
+
+public:
+    JSTD_FORCED_INLINE
+    explicit TraceScope(const char * name) : name_(name) {
+        // Make sure the registry is constructed (and destroyed) before the first event.
+        this->start_ = TraceRegistry::instance().now();
+    }
+
+    JSTD_FORCED_INLINE
+    ~TraceScope() {
+        std::uint64_t stop = TraceRegistry::instance().now();
+        get_trace_buffer()->record(this->name_, this->start_, stop - this->start_);
+    }
+
+private:
+    TraceScope(const TraceScope & src) = delete;
+    TraceScope & operator = (const TraceScope & rhs) = delete;
+};
+
+} // namespace jstd
+
+#define JSTD_TRACE_CONCAT_IMPL(a, b)    a##b
+#define JSTD_TRACE_CONCAT(a, b)         JSTD_TRACE_CONCAT_IMPL(a, b)
+
+#define JSTD_TRACE_SCOPE(name) \
+    jstd::TraceScope JSTD_TRACE_CONCAT(__jstd_trace_scope_, __LINE__)(name)
+
+#else // !JSTD_USE_TRACE_SCOPE
+
+namespace jstd {
+
+static inline
+bool trace_flush(const char * filename)
+{
+    (void)filename;
+    return false;
+}
+
+} // namespace jstd
+
+#define JSTD_TRACE_SCOPE(name)          ((void)0)
+
+#endif // JSTD_USE_TRACE_SCOPE
+
+#endif // JSTD_TRACE_SCOPE_H
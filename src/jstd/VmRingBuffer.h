@@ -0,0 +1,352 @@
+
+#ifndef JSTD_VM_RING_BUFFER_H
+#define JSTD_VM_RING_BUFFER_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include <assert.h>
+#include <cstdint>
+#include <cstddef>
+#include <cstdbool>
+#include <type_traits>
+
+#if defined(_WIN32) || defined(WIN32) || defined(OS_WINDOWS) || defined(_WINDOWS_)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#define JSTD_VM_RING_BUFFER_WIN32   1
+#elif defined(__linux__)
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#define JSTD_VM_RING_BUFFER_LINUX   1
+#endif
+
+#include "jstd/stddef.h"
+#include "jstd/ArrayRotate_SIMD.h"
+
+//
+// Double-mapped (virtual memory) ring buffer.
+//
+// The same physical pages are mapped twice, back to back:
+//
+//   | -- mapping 0 (capacity) -- | -- mapping 1 (same pages) -- |
+//   base                          base + capacity
+//
+// So, for any head in [0, capacity), [base + head, base + head + capacity)
+// is a contiguous window of the whole ring, rotate() only bumps the head
+// and doesn't move any data. Only canonicalize() physically rotates the
+// elements (with jstd::simd::rotate()) so that the window starts at base.
+//
+// See: https://fgiesen.wordpress.com/2012/07/21/the-magic-ring-buffer/
+// See: https://man7.org/linux/man-pages/man2/memfd_create.2.html
+//
+
+namespace jstd {
+
+template <typename T>
+class vm_ring_buffer {
+public:
+    typedef T                   value_type;
+    typedef T *                 pointer;
+    typedef const T *           const_pointer;
+    typedef T &                 reference;
+    typedef const T &           const_reference;
+    typedef std::size_t         size_type;
+    typedef std::ptrdiff_t      difference_type;
+    typedef vm_ring_buffer<T>   this_type;
+
+    static const size_type kValueSize = sizeof(T);
+
+private:
+    pointer     base_;
+    size_type   capacity_;
+    size_type   head_;
+    size_type   map_bytes_;
+#if defined(JSTD_VM_RING_BUFFER_WIN32)
+    HANDLE      mapping_;
+#else
+    int         fd_;
+#endif
+
+    JSTD_STATIC_ASSERT((std::is_trivially_copyable<T>::value),
+                       "jstd::vm_ring_buffer<T>: T must be trivially copyable.");
+
+public:
+    vm_ring_buffer() : base_(nullptr), capacity_(0), head_(0), map_bytes_(0) {
+#if defined(JSTD_VM_RING_BUFFER_WIN32)
+        mapping_ = NULL;
+#else
+        fd_ = -1;
+#endif
+    }
+
+    explicit vm_ring_buffer(size_type min_capacity)
+        : base_(nullptr), capacity_(0), head_(0), map_bytes_(0) {
+#if defined(JSTD_VM_RING_BUFFER_WIN32)
+        mapping_ = NULL;
+#else
+        fd_ = -1;
+#endif
+        this->create(min_capacity);
+    }
+
+    vm_ring_buffer(const this_type & src) = delete;
+    this_type & operator = (const this_type & rhs) = delete;
+
+    ~vm_ring_buffer() {
+        this->destroy();
+    }
+
+    bool is_valid() const { return (this->base_ != nullptr); }
+
+    size_type capacity() const { return this->capacity_; }
+    size_type size() const { return this->capacity_; }
+    size_type head() const { return this->head_; }
+
+    // The contiguous window of the whole ring, [data(), data() + capacity()).
+    pointer data() { return (this->base_ + this->head_); }
+    const_pointer data() const { return (this->base_ + this->head_); }
+
+    pointer begin() { return this->data(); }
+    pointer end() { return (this->data() + this->capacity_); }
+    const_pointer begin() const { return this->data(); }
+    const_pointer end() const { return (this->data() + this->capacity_); }
+
+    // The physical storage, the elements are in canonical order only when head() == 0.
+    pointer storage() { return this->base_; }
+    const_pointer storage() const { return this->base_; }
+
+    reference operator [] (size_type index) {
+        JSTD_ASSERT(index < this->capacity_ * 2 - this->head_);
+        return this->data()[index];
+    }
+
+    const_reference operator [] (size_type index) const {
+        JSTD_ASSERT(index < this->capacity_ * 2 - this->head_);
+        return this->data()[index];
+    }
+
+    // The contiguous window that starts at the logical position (offset).
+    pointer window(size_type offset) {
+        return (this->base_ + this->wrap(this->head_ + this->wrap(offset)));
+    }
+
+    const_pointer window(size_type offset) const {
+        return (this->base_ + this->wrap(this->head_ + this->wrap(offset)));
+    }
+
+    // Same as std::rotate(begin(), begin() + offset, end()), but without any copy.
+    pointer left_rotate(size_type offset) {
+        JSTD_ASSERT(this->is_valid());
+        this->head_ = this->wrap(this->head_ + this->wrap(offset));
+        return this->data();
+    }
+
+    pointer right_rotate(size_type offset) {
+        JSTD_ASSERT(this->is_valid());
+        this->head_ = this->wrap(this->head_ + (this->capacity_ - this->wrap(offset)));
+        return this->data();
+    }
+
+    pointer rotate(size_type offset) {
+        return this->left_rotate(offset);
+    }
+
+    //
+    // Physically rotate the elements, let the window start at storage() (head() == 0).
+    // Only needed when the caller requires the canonical layout at offset 0,
+    // e.g. handing the storage to an API that doesn't know about the mirror.
+    //
+    pointer canonicalize() {
+        if (this->head_ != 0) {
+            pointer first = this->base_;
+            jstd::simd::rotate(first, first + this->head_, first + this->capacity_);
+            this->head_ = 0;
+        }
+        return this->base_;
+    }
+
+    bool create(size_type min_capacity) {
+        this->destroy();
+        if (min_capacity == 0)
+            return false;
+
+        size_type page_size = this_type::page_granularity();
+        size_type bytes = this_type::round_up(min_capacity * kValueSize, page_size);
+        // The mirror boundary must be an element boundary.
+        while ((bytes % kValueSize) != 0) {
+            bytes += page_size;
+        }
+
+        void * addr = this_type::map_mirror(bytes, this->native_handle());
+        if (addr == nullptr)
+            return false;
+
+        this->base_ = static_cast<pointer>(addr);
+        this->capacity_ = bytes / kValueSize;
+        this->head_ = 0;
+        this->map_bytes_ = bytes;
+        return true;
+    }
+
+    void destroy() {
+        if (this->base_ != nullptr) {
+            this_type::unmap_mirror(this->base_, this->map_bytes_, this->native_handle());
+            this->base_ = nullptr;
+            this->capacity_ = 0;
+            this->head_ = 0;
+            this->map_bytes_ = 0;
+        }
+    }
+
+private:
+    size_type wrap(size_type offset) const {
+        return ((offset < this->capacity_) ? offset : (offset % this->capacity_));
+    }
+
+    static size_type round_up(size_type value, size_type alignment) {
+        return ((value + alignment - 1) / alignment * alignment);
+    }
+
+#if defined(JSTD_VM_RING_BUFFER_WIN32)
+
+    HANDLE & native_handle() { return this->mapping_; }
+
+    static size_type page_granularity() {
+        SYSTEM_INFO sys_info;
+        ::GetSystemInfo(&sys_info);
+        // MapViewOfFileEx() requires the address is aligned to the allocation granularity.
+        return (size_type)sys_info.dwAllocationGranularity;
+    }
+
+    static void * map_mirror(size_type bytes, HANDLE & mapping) {
+        unsigned long long map_size = (unsigned long long)bytes;
+        mapping = ::CreateFileMappingW(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                       (DWORD)(map_size >> 32), (DWORD)(map_size & 0xFFFFFFFFul),
+                                       NULL);
+        if (mapping == NULL)
+            return nullptr;
+
+        // Another thread may grab the reserved range between VirtualFree()
+        // and MapViewOfFileEx(), so retry a few times.
+        static const int kMaxRetry = 16;
+        for (int retry = 0; retry < kMaxRetry; retry++) {
+            char * addr = (char *)::VirtualAlloc(NULL, bytes * 2, MEM_RESERVE, PAGE_NOACCESS);
+            if (addr == NULL)
+                break;
+            ::VirtualFree(addr, 0, MEM_RELEASE);
+
+            void * view0 = ::MapViewOfFileEx(mapping, FILE_MAP_ALL_ACCESS, 0, 0, bytes, addr);
+            if (view0 == NULL)
+                continue;
+            void * view1 = ::MapViewOfFileEx(mapping, FILE_MAP_ALL_ACCESS, 0, 0, bytes, addr + bytes);
+            if (view1 == NULL) {
+                ::UnmapViewOfFile(view0);
+                continue;
+            }
+            return addr;
+        }
+
+        ::CloseHandle(mapping);
+        mapping = NULL;
+        return nullptr;
+    }
+
+    static void unmap_mirror(void * addr, size_type bytes, HANDLE & mapping) {
+        ::UnmapViewOfFile((char *)addr + bytes);
+        ::UnmapViewOfFile(addr);
+        if (mapping != NULL) {
+            ::CloseHandle(mapping);
+            mapping = NULL;
+        }
+    }
+
+#elif defined(JSTD_VM_RING_BUFFER_LINUX)
+
+    int & native_handle() { return this->fd_; }
+
+    static size_type page_granularity() {
+        long page_size = ::sysconf(_SC_PAGESIZE);
+        return (page_size > 0) ? (size_type)page_size : (size_type)4096;
+    }
+
+    static int memfd_open(const char * name) {
+#if defined(SYS_memfd_create)
+        // glibc before 2.27 has no memfd_create() wrapper.
+        return (int)::syscall(SYS_memfd_create, name, 1u /* MFD_CLOEXEC */);
+#else
+        return -1;
+#endif
+    }
+
+    static void * map_mirror(size_type bytes, int & fd) {
+        fd = this_type::memfd_open("jstd_vm_ring_buffer");
+        if (fd < 0)
+            return nullptr;
+
+        if (::ftruncate(fd, (off_t)bytes) != 0) {
+            ::close(fd);
+            fd = -1;
+            return nullptr;
+        }
+
+        // Reserve the address range of two mappings first, then map the same
+        // memfd pages over each half with MAP_FIXED, it's race-free.
+        char * addr = (char *)::mmap(NULL, bytes * 2, PROT_NONE,
+                                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (addr == (char *)MAP_FAILED) {
+            ::close(fd);
+            fd = -1;
+            return nullptr;
+        }
+
+        void * view0 = ::mmap(addr, bytes, PROT_READ | PROT_WRITE,
+                              MAP_SHARED | MAP_FIXED, fd, 0);
+        void * view1 = ::mmap(addr + bytes, bytes, PROT_READ | PROT_WRITE,
+                              MAP_SHARED | MAP_FIXED, fd, 0);
+        if (view0 == MAP_FAILED || view1 == MAP_FAILED) {
+            ::munmap(addr, bytes * 2);
+            ::close(fd);
+            fd = -1;
+            return nullptr;
+        }
+        return addr;
+    }
+
+    static void unmap_mirror(void * addr, size_type bytes, int & fd) {
+        ::munmap(addr, bytes * 2);
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+
+#else
+
+    int & native_handle() { return this->fd_; }
+
+    static size_type page_granularity() {
+        return 4096;
+    }
+
+    // The double mapping is not supported on this platform yet.
+    static void * map_mirror(size_type bytes, int & fd) {
+        fd = -1;
+        return nullptr;
+    }
+
+    static void unmap_mirror(void * addr, size_type bytes, int & fd) {
+        fd = -1;
+    }
+
+#endif // JSTD_VM_RING_BUFFER_WIN32
+};
+
+} // namespace jstd
+
+#endif // JSTD_VM_RING_BUFFER_H
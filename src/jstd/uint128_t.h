@@ -168,10 +168,10 @@ struct _uint128_t {
 
 #ifdef HAS_INT128_T
     _uint128_t(const __uint128_t & src) noexcept
-        : low((low_t)(src >> 64u)), high((high_t)(src & kFullMask64)) {}
+        : low((low_t)(src & kFullMask64)), high((high_t)(src >> 64u)) {}
 
     _uint128_t(const __int128_t & src) noexcept
-        : low((low_t)((__uint128_t)src >> 64u)), high((high_t)(src & kFullMask64)) {}
+        : low((low_t)(src & kFullMask64)), high((high_t)((__uint128_t)src >> 64u)) {}
 #endif
 
     _uint128_t(const this_type & src) noexcept
@@ -0,0 +1,557 @@
+
+#if defined(_MSC_VER)
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "CPUWarmUp.h"
+#include "StopWatch.h"
+#include "ItemTypes.h"
+
+#include "jstd/ArrayRotate.h"
+#include "jstd/ArrayRotate_SIMD.h"
+#include "jstd/RotateTrace.h"
+
+//
+// Rotate trace replayer.
+//
+// Replays a rotate trace (see jstd/RotateTrace.h) through every rotate implementation.
+// The records rotate a small pool of buffers in turn (record i uses buffer i % N),
+// like an allocator reuses the freed blocks, so the cache footprint between the calls
+// is close to the real workload, and each record starts at its recorded alignment.
+//
+// Each algorithm replays the whole trace, then each size class of it. After a replay,
+// the buffers must be the same as the buffers of std::rotate().
+//
+// Usage:
+//
+//   rotate_replay trace.bin [--reps=N] [--buffers=N]
+//   rotate_replay trace.bin --gen=N [--seed=N]      Write a synthetic trace, then replay it.
+//
+
+static const std::size_t kBufferAlignment = jstd::kRotateTraceAlignment;
+
+// Don't allocate more than this for one buffer.
+static const std::size_t kMaxBufferBytes = std::size_t(1) << 30;
+
+enum ReplayAlgorithm {
+    ReplayStdRotate,
+    ReplayJstdStdRotate,
+    ReplayJstdRotate,
+    ReplayLibcxxRotate,
+    ReplayFastModCycleRotate,
+    ReplayInterleavedCycleRotate,
+    ReplaySimdRotate,
+    ReplaySimdRotateReversal,
+    ReplayLast
+};
+
+static const char * const kReplayAlgorithmNames[ReplayLast] = {
+    "std::rotate",
+    "jstd::std_rotate",
+    "jstd::rotate",
+    "jstd::libcxx_rotate",
+    "jstd::fastmod_cycle_rotate",
+    "jstd::interleaved_cycle_rotate<8>",
+    "jstd::simd::rotate",
+    "jstd::simd::rotate_reversal"
+};
+
+//
+// The size classes of the report, by the bytes of a rotation.
+//
+static const std::size_t kSizeClassLimits[] = {
+    256, 4 * 1024, 256 * 1024, 8 * 1024 * 1024, std::size_t(-1)
+};
+
+static const char * const kSizeClassNames[] = {
+    "<= 256 B", "<= 4 KB", "<= 256 KB", "<= 8 MB", "> 8 MB"
+};
+
+static const std::size_t kSizeClassCount = sizeof(kSizeClassLimits) / sizeof(kSizeClassLimits[0]);
+
+struct ReplayOptions {
+    std::string     filename;
+    std::size_t     repeats;
+    std::size_t     buffers;
+    std::size_t     generate;
+    std::size_t     seed;
+
+    ReplayOptions() : repeats(5), buffers(4), generate(0), seed(20200501) {}
+};
+
+struct ReplayBuffers {
+    std::vector<char *> allocs;
+    std::vector<char *> buffers;
+    std::size_t         bytes;
+
+    ReplayBuffers() : bytes(0) {}
+
+    ~ReplayBuffers() {
+        this->destroy();
+    }
+
+    bool create(std::size_t count, std::size_t _bytes) {
+        this->destroy();
+        this->bytes = _bytes;
+        for (std::size_t i = 0; i < count; i++) {
+            char * alloc = (char *)::malloc(_bytes + kBufferAlignment);
+            if (alloc == nullptr)
+                return false;
+            char * buffer = (char *)(((uintptr_t)alloc + kBufferAlignment - 1)
+                                     & ~(uintptr_t)(kBufferAlignment - 1));
+            this->allocs.push_back(alloc);
+            this->buffers.push_back(buffer);
+        }
+        return true;
+    }
+
+    void destroy() {
+        for (std::size_t i = 0; i < this->allocs.size(); i++) {
+            ::free(this->allocs[i]);
+        }
+        this->allocs.clear();
+        this->buffers.clear();
+    }
+
+    // The neighbour elements are always different for all element sizes.
+    void fill() {
+        for (std::size_t n = 0; n < this->buffers.size(); n++) {
+            uint32_t * words = (uint32_t *)this->buffers[n];
+            std::size_t count = this->bytes / sizeof(uint32_t);
+            for (std::size_t i = 0; i < count; i++) {
+                words[i] = (uint32_t)((i + n * count) * 0x9E3779B1u);
+            }
+        }
+    }
+};
+
+static bool is_supported_elem_size(uint32_t elem_size)
+{
+    switch (elem_size) {
+        case 1: case 2: case 4: case 8:
+        case 12: case 16: case 24:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// The alignment of the element type replay_records() uses for the size.
+static uint32_t get_elem_alignment(uint32_t elem_size)
+{
+    switch (elem_size) {
+        case 1:  return (uint32_t)alignof(uint8_t);
+        case 2:  return (uint32_t)alignof(uint16_t);
+        case 4:  return (uint32_t)alignof(uint32_t);
+        case 8:  return (uint32_t)alignof(uint64_t);
+        case 12: return (uint32_t)alignof(test::item12);
+        case 16: return (uint32_t)alignof(test::item16);
+        case 24: return (uint32_t)alignof(test::item24);
+        default: return 1;
+    }
+}
+
+static std::size_t get_size_class(const jstd::RotateTraceRecord & record)
+{
+    std::size_t bytes = (std::size_t)(record.length * record.elem_size);
+    for (std::size_t size_class = 0; size_class < kSizeClassCount; size_class++) {
+        if (bytes <= kSizeClassLimits[size_class])
+            return size_class;
+    }
+    return (kSizeClassCount - 1);
+}
+
+template <typename T>
+static void replay_rotate(int algorithm, T * first, T * mid, T * last)
+{
+    switch (algorithm) {
+        case ReplayStdRotate:
+            std::rotate(first, mid, last);
+            break;
+        case ReplayJstdStdRotate:
+            jstd::std_rotate(first, mid, last);
+            break;
+        case ReplayJstdRotate:
+            jstd::rotate(first, mid, last);
+            break;
+        case ReplayLibcxxRotate:
+            jstd::libcxx_rotate(first, mid, last);
+            break;
+        case ReplayFastModCycleRotate:
+            jstd::fastmod_cycle_rotate(first, mid, last);
+            break;
+        case ReplayInterleavedCycleRotate:
+            jstd::interleaved_cycle_rotate<8>(first, mid, last);
+            break;
+        case ReplaySimdRotate:
+            jstd::simd::rotate(first, mid, last);
+            break;
+        case ReplaySimdRotateReversal:
+            jstd::simd::rotate_reversal(first, mid, last);
+            break;
+        default:
+            break;
+    }
+}
+
+template <typename T>
+static void replay_record(int algorithm, char * buffer, const jstd::RotateTraceRecord & record)
+{
+    T * first = (T *)(buffer + record.alignment);
+    replay_rotate<T>(algorithm, first, first + (std::size_t)record.offset,
+                     first + (std::size_t)record.length);
+}
+
+static void replay_records(int algorithm, ReplayBuffers & buffers,
+                           const std::vector<jstd::RotateTraceRecord> & records)
+{
+    std::size_t buffer_count = buffers.buffers.size();
+    std::size_t index = 0;
+    for (std::size_t i = 0; i < records.size(); i++) {
+        const jstd::RotateTraceRecord & record = records[i];
+        char * buffer = buffers.buffers[index];
+        switch (record.elem_size) {
+            case 1:
+                replay_record<uint8_t>(algorithm, buffer, record);
+                break;
+            case 2:
+                replay_record<uint16_t>(algorithm, buffer, record);
+                break;
+            case 4:
+                replay_record<uint32_t>(algorithm, buffer, record);
+                break;
+            case 8:
+                replay_record<uint64_t>(algorithm, buffer, record);
+                break;
+            case 12:
+                replay_record<test::item12>(algorithm, buffer, record);
+                break;
+            case 16:
+                replay_record<test::item16>(algorithm, buffer, record);
+                break;
+            case 24:
+                replay_record<test::item24>(algorithm, buffer, record);
+                break;
+            default:
+                break;
+        }
+        index++;
+        if (index >= buffer_count)
+            index = 0;
+    }
+}
+
+//
+// Returns the best time of the repeats (unit: ms), the buffers are refilled before
+// each repeat, so they are the result of one replay at the end.
+//
+static double replay_benchmark(int algorithm, ReplayBuffers & buffers,
+                               const std::vector<jstd::RotateTraceRecord> & records,
+                               std::size_t repeats)
+{
+    test::StopWatch sw;
+    double best_time = -1.0;
+    for (std::size_t repeat = 0; repeat < repeats; repeat++) {
+        buffers.fill();
+        sw.start();
+        replay_records(algorithm, buffers, records);
+        sw.stop();
+        double elapsed = sw.getElapsedMillisec();
+        if (best_time < 0.0 || elapsed < best_time)
+            best_time = elapsed;
+    }
+    return best_time;
+}
+
+static bool verify_buffers(const ReplayBuffers & buffers, const std::vector<char> & expected)
+{
+    std::size_t bytes = buffers.bytes;
+    for (std::size_t n = 0; n < buffers.buffers.size(); n++) {
+        if (::memcmp(buffers.buffers[n], &expected[n * bytes], bytes) != 0)
+            return false;
+    }
+    return true;
+}
+
+static void save_buffers(const ReplayBuffers & buffers, std::vector<char> & expected)
+{
+    std::size_t bytes = buffers.bytes;
+    expected.resize(buffers.buffers.size() * bytes);
+    for (std::size_t n = 0; n < buffers.buffers.size(); n++) {
+        ::memcpy(&expected[n * bytes], buffers.buffers[n], bytes);
+    }
+}
+
+static void replay_report(const char * title, ReplayBuffers & buffers,
+                          const std::vector<jstd::RotateTraceRecord> & records,
+                          std::size_t repeats, int & failed)
+{
+    double elapsed[ReplayLast];
+    bool verified[ReplayLast];
+    std::vector<char> expected;
+
+    double best_time = -1.0;
+    for (int algorithm = 0; algorithm < ReplayLast; algorithm++) {
+        elapsed[algorithm] = replay_benchmark(algorithm, buffers, records, repeats);
+        if (algorithm == ReplayStdRotate) {
+            save_buffers(buffers, expected);
+            verified[algorithm] = true;
+        } else {
+            verified[algorithm] = verify_buffers(buffers, expected);
+            if (!verified[algorithm])
+                failed++;
+        }
+        if (best_time < 0.0 || elapsed[algorithm] < best_time)
+            best_time = elapsed[algorithm];
+    }
+
+    printf(" %s: %u calls\n\n", title, (uint32_t)records.size());
+    printf("  %-36s %12s %12s %8s\n", "algorithm", "total ms", "ns/call", "ratio");
+    printf("  ---------------------------------------------------------------------------\n");
+    for (int algorithm = 0; algorithm < ReplayLast; algorithm++) {
+        double ns_per_call = elapsed[algorithm] * 1000000.0 / (double)records.size();
+        double ratio = (best_time > 0.0) ? (elapsed[algorithm] / best_time) : 1.0;
+        printf("  %-36s %12.3f %12.1f %7.2fx%s\n",
+               kReplayAlgorithmNames[algorithm], elapsed[algorithm], ns_per_call, ratio,
+               verified[algorithm] ? "" : "  Failed");
+    }
+    printf("\n");
+}
+
+//
+// A simple xorshift64* generator, the same trace for the same seed on all platforms.
+//
+static uint64_t next_random(uint64_t & state)
+{
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return (state * 0x2545F4914F6CDD1Dull);
+}
+
+//
+// A synthetic trace, most rotations are small (like the real workloads),
+// a few of them are big, the offsets are small, large or in the middle.
+//
+static bool generate_trace(const char * filename, std::size_t count, std::size_t seed)
+{
+    static const uint32_t kElemSizes[] = { 1, 2, 4, 4, 4, 8, 8, 12, 16, 24 };
+    static const std::size_t kElemSizeCount = sizeof(kElemSizes) / sizeof(kElemSizes[0]);
+
+    jstd::RotateTraceWriter writer;
+    if (!writer.open(filename)) {
+        fprintf(stderr, "Error: can't create the trace file: %s\n\n", filename);
+        return false;
+    }
+
+    uint64_t state = (uint64_t)seed * 0x9E3779B97F4A7C15ull + 1;
+    for (std::size_t i = 0; i < count; i++) {
+        uint32_t elem_size = kElemSizes[next_random(state) % kElemSizeCount];
+
+        // log2(bytes): 70% in [3, 12), 25% in [12, 20), 5% in [20, 25).
+        uint32_t percent = (uint32_t)(next_random(state) % 100);
+        uint32_t log2_bytes;
+        if (percent < 70)
+            log2_bytes = 3 + (uint32_t)(next_random(state) % 9);
+        else if (percent < 95)
+            log2_bytes = 12 + (uint32_t)(next_random(state) % 8);
+        else
+            log2_bytes = 20 + (uint32_t)(next_random(state) % 5);
+
+        std::size_t bytes = (std::size_t(1) << log2_bytes);
+        bytes += (std::size_t)(next_random(state) % bytes);
+        std::size_t length = bytes / elem_size;
+        if (length < 2)
+            length = 2;
+
+        std::size_t offset;
+        uint32_t offset_type = (uint32_t)(next_random(state) % 4);
+        if (offset_type == 0)
+            offset = 1 + (std::size_t)(next_random(state) % 8);
+        else if (offset_type == 1)
+            offset = length - 1 - (std::size_t)(next_random(state) % 8);
+        else
+            offset = 1 + (std::size_t)(next_random(state) % (length - 1));
+        if (offset < 1 || offset >= length)
+            offset = 1;
+
+        // Most buffers are aligned to 16 bytes (malloc), some are not, but
+        // never less than the element type, the same as a real T *.
+        uint32_t alignment;
+        if ((next_random(state) % 4) != 0)
+            alignment = (uint32_t)((next_random(state) % 4) * 16);
+        else
+            alignment = (uint32_t)(next_random(state) % kBufferAlignment);
+        alignment &= ~(get_elem_alignment(elem_size) - 1);
+
+        writer.append(length, offset, elem_size, alignment);
+    }
+    writer.close();
+
+    printf(" Generated %u records: %s\n\n", (uint32_t)count, filename);
+    return true;
+}
+
+static bool load_trace(const char * filename, std::vector<jstd::RotateTraceRecord> & records,
+                       std::size_t & skipped)
+{
+    jstd::RotateTraceReader reader;
+    if (!reader.open(filename)) {
+        fprintf(stderr, "Error: can't open the trace or it's not a rotate trace: %s\n\n", filename);
+        return false;
+    }
+
+    records.clear();
+    if (reader.count() != 0)
+        records.reserve((std::size_t)reader.count());
+
+    skipped = 0;
+    jstd::RotateTraceRecord record;
+    while (reader.next(record)) {
+        // The empty rotations (offset = 0 or length) return at once,
+        // and libcxx_rotate() doesn't accept them. A misaligned T * can't be
+        // in a real trace, and the scalar rotations can't run on it.
+        // The buffer size is checked part by part, (length * elem_size) of
+        // a corrupt trace may overflow.
+        if (!is_supported_elem_size(record.elem_size) ||
+            (record.alignment % get_elem_alignment(record.elem_size)) != 0 ||
+            record.offset == 0 || record.offset >= record.length ||
+            record.elem_size == 0 || record.alignment > kMaxBufferBytes ||
+            record.length > (kMaxBufferBytes - record.alignment) / record.elem_size) {
+            skipped++;
+            continue;
+        }
+        records.push_back(record);
+    }
+    return true;
+}
+
+static void print_usage(const char * program)
+{
+    printf("Usage: %s trace.bin [options]\n\n", program);
+    printf("  --reps=N             Replays per algorithm, the best is reported, default: 5.\n");
+    printf("  --buffers=N          The buffers are reused in turn, default: 4.\n");
+    printf("  --gen=N              Write a synthetic trace of N records to trace.bin first.\n");
+    printf("  --seed=N             The seed of the synthetic trace.\n");
+    printf("  --help               Show this help.\n\n");
+}
+
+static bool parse_options(int argc, char * argv[], ReplayOptions & options)
+{
+    for (int i = 1; i < argc; i++) {
+        const char * arg = argv[i];
+        const char * value = ::strchr(arg, '=');
+        std::string name = (value != nullptr) ? std::string(arg, value - arg) : std::string(arg);
+        if (value != nullptr)
+            value++;
+
+        bool ok = true;
+        if (arg[0] != '-') {
+            options.filename = arg;
+        } else if (name == "--help" || name == "-h") {
+            return false;
+        } else if (value == nullptr) {
+            ok = false;
+        } else if (name == "--reps") {
+            options.repeats = (std::size_t)::strtoull(value, nullptr, 10);
+            ok = (options.repeats > 0);
+        } else if (name == "--buffers") {
+            options.buffers = (std::size_t)::strtoull(value, nullptr, 10);
+            ok = (options.buffers > 0);
+        } else if (name == "--gen") {
+            options.generate = (std::size_t)::strtoull(value, nullptr, 10);
+            ok = (options.generate > 0);
+        } else if (name == "--seed") {
+            options.seed = (std::size_t)::strtoull(value, nullptr, 10);
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            fprintf(stderr, "Error: bad option: %s\n\n", arg);
+            return false;
+        }
+    }
+    return !options.filename.empty();
+}
+
+int main(int argc, char * argv[])
+{
+    ReplayOptions options;
+    if (!parse_options(argc, argv, options)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    if (options.generate != 0) {
+        if (!generate_trace(options.filename.c_str(), options.generate, options.seed))
+            return 1;
+    }
+
+    std::vector<jstd::RotateTraceRecord> records;
+    std::size_t skipped;
+    if (!load_trace(options.filename.c_str(), records, skipped))
+        return 1;
+
+    if (records.empty()) {
+        fprintf(stderr, "Error: no record to replay (%u skipped).\n\n", (uint32_t)skipped);
+        return 1;
+    }
+
+    std::size_t max_bytes = 0;
+    uint64_t total_bytes = 0;
+    std::vector<jstd::RotateTraceRecord> class_records[kSizeClassCount];
+    for (std::size_t i = 0; i < records.size(); i++) {
+        const jstd::RotateTraceRecord & record = records[i];
+        std::size_t bytes = (std::size_t)(record.length * record.elem_size);
+        if (bytes + record.alignment > max_bytes)
+            max_bytes = bytes + record.alignment;
+        total_bytes += bytes;
+        class_records[get_size_class(record)].push_back(record);
+    }
+
+    ReplayBuffers buffers;
+    // Round up to the word size of ReplayBuffers::fill().
+    if (!buffers.create(options.buffers, (max_bytes + 3) & ~(std::size_t)3)) {
+        fprintf(stderr, "Error: out of memory, %u buffers of %u bytes.\n\n",
+                (uint32_t)options.buffers, (uint32_t)max_bytes);
+        return 1;
+    }
+
+    printf("\n");
+    printf(" Trace: %s\n", options.filename.c_str());
+    printf(" Records: %u (%u skipped), %0.1f MB rotated, buffers: %u x %u bytes, reps: %u\n\n",
+           (uint32_t)records.size(), (uint32_t)skipped,
+           (double)total_bytes / (1024.0 * 1024.0),
+           (uint32_t)options.buffers, (uint32_t)buffers.bytes, (uint32_t)options.repeats);
+
+    test::CPU::warm_up(1000);
+
+    int failed = 0;
+    replay_report("All", buffers, records, options.repeats, failed);
+    for (std::size_t size_class = 0; size_class < kSizeClassCount; size_class++) {
+        if (!class_records[size_class].empty()) {
+            replay_report(kSizeClassNames[size_class], buffers, class_records[size_class],
+                          options.repeats, failed);
+        }
+    }
+
+    if (failed != 0) {
+        printf(" %d replays are different from std::rotate().\n\n", failed);
+        return 1;
+    }
+    return 0;
+}